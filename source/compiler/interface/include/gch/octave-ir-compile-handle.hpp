@@ -0,0 +1,200 @@
+/** octave-ir-compile-handle.hpp
+ * A handle to the result of an asynchronous compilation.
+ *
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef OCTAVE_IR_COMPILER_OCTAVE_IR_COMPILE_HANDLE_HPP
+#define OCTAVE_IR_COMPILER_OCTAVE_IR_COMPILE_HANDLE_HPP
+
+#include "ir-error.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace gch
+{
+
+  class octave_jit_compile_state
+  {
+  public:
+    enum class status
+    {
+      pending,
+      running,
+      finished,
+      failed,
+      cancelled,
+    };
+
+    octave_jit_compile_state            (void)                                = default;
+    octave_jit_compile_state            (const octave_jit_compile_state&)     = delete;
+    octave_jit_compile_state            (octave_jit_compile_state&&) noexcept = delete;
+    octave_jit_compile_state& operator= (const octave_jit_compile_state&)     = delete;
+    octave_jit_compile_state& operator= (octave_jit_compile_state&&) noexcept = delete;
+    ~octave_jit_compile_state           (void)                                = default;
+
+    // Returns false if the job was cancelled before it could start.
+    bool
+    try_start (void)
+    {
+      std::scoped_lock lock (m_mutex);
+      if (m_status != status::pending)
+        return false;
+      m_status = status::running;
+      return true;
+    }
+
+    void
+    set_result (void *result)
+    {
+      {
+        std::scoped_lock lock (m_mutex);
+        m_result = result;
+        m_status = status::finished;
+      }
+      m_cv.notify_all ();
+    }
+
+    void
+    set_exception (std::exception_ptr ptr)
+    {
+      {
+        std::scoped_lock lock (m_mutex);
+        m_exception = std::move (ptr);
+        m_status    = status::failed;
+      }
+      m_cv.notify_all ();
+    }
+
+    // Only jobs which have not started may be cancelled.
+    bool
+    cancel (void)
+    {
+      {
+        std::scoped_lock lock (m_mutex);
+        if (m_status != status::pending)
+          return false;
+        m_status = status::cancelled;
+      }
+      m_cv.notify_all ();
+      return true;
+    }
+
+    [[nodiscard]]
+    status
+    get_status (void) const
+    {
+      std::scoped_lock lock (m_mutex);
+      return m_status;
+    }
+
+    void
+    wait (void) const
+    {
+      std::unique_lock lock (m_mutex);
+      m_cv.wait (lock, [&] { return is_done (); });
+    }
+
+    [[nodiscard]]
+    void *
+    get (void) const
+    {
+      std::unique_lock lock (m_mutex);
+      m_cv.wait (lock, [&] { return is_done (); });
+
+      if (m_status == status::failed)
+        std::rethrow_exception (m_exception);
+      if (m_status == status::cancelled)
+        throw ir_exception ("The compilation job was cancelled.");
+      return m_result;
+    }
+
+  private:
+    [[nodiscard]]
+    bool
+    is_done (void) const noexcept
+    {
+      return m_status != status::pending && m_status != status::running;
+    }
+
+    mutable std::mutex              m_mutex;
+    mutable std::condition_variable m_cv;
+    status                          m_status = status::pending;
+    void                           *m_result = nullptr;
+    std::exception_ptr              m_exception;
+  };
+
+  class octave_jit_compile_handle
+  {
+  public:
+    using status = octave_jit_compile_state::status;
+
+    octave_jit_compile_handle            (void)                                 = default;
+    octave_jit_compile_handle            (const octave_jit_compile_handle&)     = default;
+    octave_jit_compile_handle            (octave_jit_compile_handle&&) noexcept = default;
+    octave_jit_compile_handle& operator= (const octave_jit_compile_handle&)     = default;
+    octave_jit_compile_handle& operator= (octave_jit_compile_handle&&) noexcept = default;
+    ~octave_jit_compile_handle           (void)                                 = default;
+
+    explicit
+    octave_jit_compile_handle (std::shared_ptr<octave_jit_compile_state> state) noexcept
+      : m_state (std::move (state))
+    { }
+
+    [[nodiscard]]
+    bool
+    valid (void) const noexcept
+    {
+      return m_state != nullptr;
+    }
+
+    [[nodiscard]]
+    status
+    get_status (void) const
+    {
+      return m_state->get_status ();
+    }
+
+    [[nodiscard]]
+    bool
+    is_ready (void) const
+    {
+      status s = get_status ();
+      return s != status::pending && s != status::running;
+    }
+
+    void
+    wait (void) const
+    {
+      m_state->wait ();
+    }
+
+    // Blocks until the job is done, then returns the entry point. Rethrows any error raised
+    // during compilation, and throws `ir_exception` if the job was cancelled.
+    [[nodiscard]]
+    void *
+    get (void) const
+    {
+      return m_state->get ();
+    }
+
+    bool
+    cancel (void)
+    {
+      return m_state->cancel ();
+    }
+
+  private:
+    std::shared_ptr<octave_jit_compile_state> m_state;
+  };
+
+}
+
+#endif // OCTAVE_IR_COMPILER_OCTAVE_IR_COMPILE_HANDLE_HPP
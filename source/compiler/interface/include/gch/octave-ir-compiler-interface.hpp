@@ -8,15 +8,146 @@
 #ifndef OCTAVE_IR_COMPILER_OCTAVE_IR_COMPILER_INTERFACE_HPP
 #define OCTAVE_IR_COMPILER_OCTAVE_IR_COMPILER_INTERFACE_HPP
 
+#include "gch/octave-ir-compile-handle.hpp"
+#include "gch/octave-ir-jit-function.hpp"
+#include "ir-error.hpp"
 #include "ir-static-function.hpp"
+#include "ir-type.hpp"
 
+#include <gch/nonnull_ptr.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iterator>
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 namespace gch
 {
+
+  enum class octave_jit_optimization_level
+  {
+    O0, // Lowest latency; no IR optimization.
+    O1,
+    O2, // Default.
+    O3, // Highest throughput of the generated code.
+    Os,
+    Oz,
+  };
+
+  // A library of vectorized math functions which loops calling math functions may be
+  // vectorized against.
+  enum class octave_jit_vector_library
+  {
+    none,    // Default.
+    libmvec, // From glibc, for x86-64.
+    svml,    // From Intel, for x86.
+  };
+
+  struct octave_jit_memory_usage
+  {
+    std::size_t reserved  = 0; // Mapped from the system.
+    std::size_t allocated = 0; // Handed out to objects, including padding to page boundaries.
+    std::size_t used      = 0; // Occupied by sections.
+
+    // The fraction of the free memory which lies outside of the largest free range.
+    double fragmentation = 0.0;
+  };
+
+  struct octave_jit_memory_stats
+  {
+    octave_jit_memory_usage code;
+    octave_jit_memory_usage rodata;
+    octave_jit_memory_usage data;
+  };
+
+  enum class octave_jit_compile_phase
+  {
+    translate, // Static IR to LLVM IR.
+    optimize,
+    codegen,   // Instruction selection and object emission.
+    link,      // Includes loading objects found in the object cache.
+  };
+
+  inline constexpr std::size_t octave_jit_num_compile_phases = 4;
+
+  struct octave_jit_phase_stats
+  {
+    std::size_t              count = 0;
+    std::chrono::nanoseconds time  { 0 };
+  };
+
+  using octave_jit_phase_stats_array =
+    std::array<octave_jit_phase_stats, octave_jit_num_compile_phases>;
+
+  // Functions compiled together (as by `compile_batch`) share a module.
+  struct octave_jit_module_stats
+  {
+    std::vector<std::string>     functions;
+    std::size_t                  num_blocks       = 0;
+    std::size_t                  num_instructions = 0;
+    std::size_t                  code_size        = 0; // Bytes in executable sections.
+    bool                         cached           = false;
+    octave_jit_phase_stats_array phases;
+  };
+
+  struct octave_jit_compile_stats
+  {
+    octave_jit_phase_stats_array         phases;
+    std::vector<octave_jit_module_stats> modules;
+  };
+
+  // The static IR which generated a piece of compiled code.
+  struct octave_jit_source_location
+  {
+    std::string function;
+    std::size_t block_index;
+    std::string block_name;
+    std::size_t instruction_index;
+  };
+
+  // A function loaded from an object emitted ahead of time.
+  struct octave_jit_aot_function
+  {
+    std::string name;
+    std::string signature;
+    void       *address;
+  };
+
+  // Facts about a runtime function which let calls to it be optimized. A function which may
+  // raise an error as an exception must not be marked `does_not_throw`.
+  struct octave_jit_runtime_attributes
+  {
+    bool does_not_throw         = false;
+    bool does_not_return        = false;
+    bool does_not_access_memory = false;
+  };
+
+  // A host function which compiled code calls by name through an external function.
+  struct octave_jit_runtime_function
+  {
+    std::string                   name;
+    void                         *address;
+    ir_type                       return_type;
+    std::vector<ir_type>          arg_types;
+    bool                          is_variadic;
+    octave_jit_runtime_attributes attributes;
+  };
+
+  // Calls a function with its arguments and result passed through untyped pointers.
+  using octave_jit_boxed_function = void (*) (void **args, void *ret);
+
   class octave_jit_compiler_impl
   {
   public:
+    using function_refs = std::vector<nonnull_ptr<const ir_static_function>>;
+
     octave_jit_compiler_impl            (void)                                = default;
     octave_jit_compiler_impl            (const octave_jit_compiler_impl&)     = default;
     octave_jit_compiler_impl            (octave_jit_compiler_impl&&) noexcept = default;
@@ -28,12 +159,218 @@ namespace gch
     void *
     compile (const ir_static_function& func) = 0;
 
+    // Backends without batching compile each function separately.
+    virtual
+    std::vector<void *>
+    compile_batch (const function_refs& funcs)
+    {
+      std::vector<void *> ret;
+      ret.reserve (funcs.size ());
+      std::transform (funcs.begin (), funcs.end (), std::back_inserter (ret),
+                      [&](nonnull_ptr<const ir_static_function> func) { return compile (*func); });
+      return ret;
+    }
+
+    // Backends without map entry points return nullptr.
+    virtual
+    void *
+    compile_map (const ir_static_function&)
+    {
+      return nullptr;
+    }
+
+    // Backends without boxed entry points return nullptr.
+    virtual
+    void *
+    compile_boxed (const ir_static_function&)
+    {
+      return nullptr;
+    }
+
+    // Backends without lazy compilation compile eagerly.
+    virtual
+    void *
+    compile_lazy (ir_static_function&& func)
+    {
+      return compile (func);
+    }
+
+    // Backends without a worker pool compile on the calling thread.
+    virtual
+    octave_jit_compile_handle
+    compile_async (ir_static_function&& func, int)
+    {
+      auto state = std::make_shared<octave_jit_compile_state> ();
+      if (state->try_start ())
+      {
+        try
+        {
+          state->set_result (compile (func));
+        }
+        catch (...)
+        {
+          state->set_exception (std::current_exception ());
+        }
+      }
+      return octave_jit_compile_handle { std::move (state) };
+    }
+
+    // Backends which cannot free code keep it for the life of the compiler.
+    virtual
+    bool
+    release (std::string_view)
+    {
+      return false;
+    }
+
+    virtual
+    void *
+    replace (ir_static_function&& func)
+    {
+      release (func.get_name ());
+      return compile (func);
+    }
+
+    // Backends without redirectable entry points return nullptr.
+    virtual
+    void *
+    publish (ir_static_function&&)
+    {
+      return nullptr;
+    }
+
+    virtual
+    bool
+    redirect (std::string_view, std::size_t)
+    {
+      return false;
+    }
+
+    [[nodiscard]]
+    virtual
+    void *
+    find (std::string_view) const
+    {
+      return nullptr;
+    }
+
+    // Backends without a runtime library look up external functions in the process.
+    virtual
+    void
+    register_runtime_function (octave_jit_runtime_function)
+    { }
+
+    virtual
+    void
+    emit_object (const function_refs&, std::string_view)
+    {
+      throw ir_exception ("This backend cannot emit objects.");
+    }
+
+    // Backends without ahead-of-time objects load nothing.
+    virtual
+    std::vector<octave_jit_aot_function>
+    load_object (std::string_view)
+    {
+      return { };
+    }
+
+    [[nodiscard]]
+    virtual
+    octave_jit_memory_stats
+    get_memory_stats (void) const
+    {
+      return { };
+    }
+
+    virtual
+    void
+    enable_statistics (bool)
+    { }
+
+    virtual
+    void
+    reset_statistics (void)
+    { }
+
+    [[nodiscard]]
+    virtual
+    octave_jit_compile_stats
+    get_statistics (void) const
+    {
+      return { };
+    }
+
+    [[nodiscard]]
+    virtual
+    std::string
+    get_chrome_trace (void) const
+    {
+      return "[]";
+    }
+
     virtual
     void
     enable_printing (bool)
     { }
+
+    virtual
+    void
+    set_optimization_level (octave_jit_optimization_level)
+    { }
+
+    virtual
+    void
+    append_passes (std::string_view)
+    { }
+
+    virtual
+    void
+    clear_passes (void)
+    { }
+
+    virtual
+    void
+    set_target_cpu (std::string_view, std::string_view)
+    { }
+
+    virtual
+    void
+    set_vector_library (octave_jit_vector_library)
+    { }
+
+    virtual
+    void
+    enable_object_cache (std::string_view, std::size_t)
+    { }
+
+    virtual
+    void
+    disable_object_cache (void)
+    { }
+
+    virtual
+    void
+    enable_jit_registration (void)
+    { }
+
+    virtual
+    void
+    enable_debug_info (bool)
+    { }
+
+    [[nodiscard]]
+    virtual
+    std::optional<octave_jit_source_location>
+    find_source_location (const void *) const
+    {
+      return std::nullopt;
+    }
   };
 
+  // The member functions may be called concurrently from any number of threads, so a single
+  // compiler (see `get_shared`) can serve a whole process. Settings apply to functions whose
+  // compilation starts after the call returns.
   class octave_jit_compiler
   {
     template <typename T>
@@ -41,6 +378,8 @@ namespace gch
     { };
 
   public:
+    using function_refs = octave_jit_compiler_impl::function_refs;
+
     octave_jit_compiler            (void)                           = default;
     octave_jit_compiler            (const octave_jit_compiler&)     = delete;
     octave_jit_compiler            (octave_jit_compiler&&) noexcept = default;
@@ -48,12 +387,222 @@ namespace gch
     octave_jit_compiler& operator= (octave_jit_compiler&&) noexcept = default;
     virtual ~octave_jit_compiler   (void)                           = default;
 
+    // Compiled code may be unwound, so exceptions thrown by external functions which it calls
+    // (such as `throw_error` for uninitialized variables) propagate out of the entry point to
+    // the caller. Calls need no setup beyond that of a plain function call.
     void *
     compile (const ir_static_function& func)
     {
       return m_impl->compile (func);
     }
 
+    // Compiles the function and returns a handle which calls it with the given signature, for
+    // example `compile<double (double, double)> (func)`. Throws `ir_exception` before compiling
+    // if the signature does not match the argument and return types of the function.
+    template <typename Signature>
+    octave_jit_function<Signature>
+    compile (const ir_static_function& func)
+    {
+      octave_jit_function<Signature>::check_signature (func);
+      return octave_jit_function<Signature> (compile (func));
+    }
+
+    // Translates the functions into a single module and emits them as one object, which avoids
+    // paying the per-module overhead for each one. Calls between the functions (see
+    // `ir_external_function_info::linkage::jit`) are direct, so small callees may be inlined.
+    // Throws `ir_exception` if any function calls one which is neither in the batch nor compiled
+    // already. Returns the entry points in order.
+    std::vector<void *>
+    compile_batch (const function_refs& funcs)
+    {
+      return m_impl->compile_batch (funcs);
+    }
+
+    // Returns an entry point which applies the function elementwise, with the signature
+    //   void (const A1 *a1, ..., const An *an, R *out, std::size_t n)
+    // where `out` is omitted if the function returns nothing. The function body is inlined into
+    // the loop so that it may be vectorized, which makes this much cheaper than calling the
+    // scalar entry point once per element. The arrays must not overlap. The entry point may be
+    // released under the name `<name>.map`. Returns nullptr if the backend does not support it.
+    void *
+    compile_map (const ir_static_function& func)
+    {
+      return m_impl->compile_map (func);
+    }
+
+    // Returns an entry point which calls the function with `args[i]` pointing to the i-th
+    // argument and stores the result (if any) through `ret`, for callers which only know the
+    // types at runtime. The pointers must refer to objects of the types of the corresponding
+    // variables. The entry point may be released under the name `<name>.boxed`. Returns
+    // nullptr if the backend does not support it.
+    octave_jit_boxed_function
+    compile_boxed (const ir_static_function& func)
+    {
+      return reinterpret_cast<octave_jit_boxed_function> (m_impl->compile_boxed (func));
+    }
+
+    // Returns a stub which translates and compiles the function when it is first called.
+    void *
+    compile_lazy (ir_static_function func)
+    {
+      return m_impl->compile_lazy (std::move (func));
+    }
+
+    // Jobs with a higher priority are started first. Jobs which have not yet started may be
+    // cancelled through the returned handle.
+    octave_jit_compile_handle
+    compile_async (ir_static_function func, int priority = 0)
+    {
+      return m_impl->compile_async (std::move (func), priority);
+    }
+
+    // Removes the named function. Entry points previously returned for it must not be called
+    // afterward. Code is freed as a unit once no function refers to it, so functions which share
+    // the code, either through deduplication or by having been compiled in the same batch, are
+    // unaffected. Until then, a name under which the shared code was first compiled cannot be
+    // defined again. Returns false if no function with the name has been compiled, or if the
+    // code is the version which a published entry point currently refers to.
+    bool
+    release (std::string_view name)
+    {
+      return m_impl->release (name);
+    }
+
+    // Compiles the new definition, then releases any function with the same name (see
+    // `release`). If compilation fails, the old definition is left in place. Throws
+    // `ir_exception` if the name refers to a published function, or if the old definition is
+    // shared code which was first compiled under the name.
+    void *
+    replace (ir_static_function func)
+    {
+      return m_impl->replace (std::move (func));
+    }
+
+    // Compiles the function as a new version named `<name>#<generation>`, where the generation
+    // counts up from 1, and atomically redirects the entry point for `<name>` to it. The entry
+    // point is the same for every version, so callers which hold it call the newest version
+    // without looking it up again, and the old and new versions never collide. Other compiled
+    // code can call the entry point by its name. Each version may be released under its
+    // versioned name, but not while the entry point refers to it. The name may not be used by
+    // functions compiled any other way; `ir_exception` is thrown if it already is. Returns
+    // nullptr if the backend does not support it.
+    void *
+    publish (ir_static_function func)
+    {
+      return m_impl->publish (std::move (func));
+    }
+
+    // Atomically points the entry point for `name` at an earlier version, as when rolling back.
+    // Returns false if no such version has been published, or if it has been released.
+    bool
+    redirect (std::string_view name, std::size_t generation)
+    {
+      return m_impl->redirect (name, generation);
+    }
+
+    // Returns the entry point compiled or published under `name` (which may be versioned) from
+    // a cache, without going through the JIT. Returns nullptr if there is none.
+    [[nodiscard]]
+    void *
+    find (std::string_view name) const
+    {
+      return m_impl->find (name);
+    }
+
+    // Binds calls to the external function `func.name` directly to `func.address`, instead of
+    // looking the name up in the process whenever code which calls it is linked. The function
+    // is declared with the given signature and attributes in every module which calls it, and
+    // calls with a different signature are rejected. Functions must be registered before any
+    // code which calls them is compiled, and cannot be unregistered. Throws `ir_exception` if
+    // the name is already taken.
+    void
+    register_runtime_function (octave_jit_runtime_function func)
+    {
+      m_impl->register_runtime_function (std::move (func));
+    }
+
+    // For example `register_runtime_function ("print_error", &print_error)`.
+    template <typename R, typename ...Args>
+    void
+    register_runtime_function (std::string_view name, R (*func) (Args...),
+                               octave_jit_runtime_attributes attributes = { })
+    {
+      static_assert (std::conjunction_v<is_ir_type<Args>...>,
+                     "Each argument type must have a corresponding IR type.");
+
+      static_assert (std::is_void_v<R> || is_ir_type_v<R>,
+                     "The result type must be void or have a corresponding IR type.");
+
+      register_runtime_function ({
+        std::string (name),
+        reinterpret_cast<void *> (func),
+        ir_type_v<R>,
+        { ir_type_v<Args>... },
+        false,
+        attributes
+      });
+    }
+
+    // Compiles the functions ahead of time into a relocatable object at `path`, with a
+    // manifest of their names and signatures at `<path>.manifest`. The object is built for the
+    // current target and optimization settings, and does not depend on this compiler. Each file
+    // is replaced atomically. Throws `ir_exception` if the backend cannot emit objects, or if
+    // the files cannot be written.
+    void
+    emit_object (const function_refs& funcs, std::string_view path)
+    {
+      m_impl->emit_object (funcs, path);
+    }
+
+    // Links an object written by `emit_object` into this compiler without compiling anything.
+    // Its functions are registered as if they had been compiled here, so they may be found,
+    // called by name from other compiled code, and released. Throws `ir_exception` if the
+    // object was emitted for a different target or with different optimization settings.
+    // Returns the entries of the manifest along with their addresses.
+    std::vector<octave_jit_aot_function>
+    load_object (std::string_view path)
+    {
+      return m_impl->load_object (path);
+    }
+
+    // Reports the memory held for compiled code and data, by section kind, in bytes.
+    [[nodiscard]]
+    octave_jit_memory_stats
+    get_memory_stats (void) const
+    {
+      return m_impl->get_memory_stats ();
+    }
+
+    // Records the time spent in each phase of compilation, along with the size of each module,
+    // for modules emitted while enabled. Statistics accumulate until they are reset.
+    void
+    enable_statistics (bool enable = true)
+    {
+      m_impl->enable_statistics (enable);
+    }
+
+    void
+    reset_statistics (void)
+    {
+      m_impl->reset_statistics ();
+    }
+
+    [[nodiscard]]
+    octave_jit_compile_stats
+    get_statistics (void) const
+    {
+      return m_impl->get_statistics ();
+    }
+
+    // Returns the recorded phases as a JSON array of trace events, which may be loaded in
+    // chrome://tracing or Perfetto.
+    [[nodiscard]]
+    std::string
+    get_chrome_trace (void) const
+    {
+      return m_impl->get_chrome_trace ();
+    }
+
     template <typename T, typename ...Args>
     static
     octave_jit_compiler
@@ -62,12 +611,109 @@ namespace gch
       return octave_jit_compiler { type_tag<T> { }, std::forward<Args> (args)... };
     }
 
+    // Returns a compiler for the backend which is created on first use and shared by every
+    // caller in the process. Setting up a compiler is expensive, so workers should share this
+    // rather than each creating their own.
+    template <typename T>
+    static
+    octave_jit_compiler&
+    get_shared (void)
+    {
+      static octave_jit_compiler compiler = create<T> ();
+      return compiler;
+    }
+
     void
     enable_printing (bool printing = true)
     {
       m_impl->enable_printing (printing);
     }
 
+    // Applies to functions compiled after the call. Functions already compiled (or structurally
+    // identical to ones already compiled) keep the code they were compiled with.
+    void
+    set_optimization_level (octave_jit_optimization_level level)
+    {
+      m_impl->set_optimization_level (level);
+    }
+
+    // Appends passes, given in the textual pipeline syntax of the backend, which run after the
+    // standard pipeline for the current optimization level.
+    void
+    append_passes (std::string_view pipeline)
+    {
+      m_impl->append_passes (pipeline);
+    }
+
+    void
+    clear_passes (void)
+    {
+      m_impl->clear_passes ();
+    }
+
+    // Generates code for `cpu` rather than the host, which makes the output reproducible across
+    // machines. `features` (such as "+avx2,-avx512f") adjusts the defaults of the CPU. An empty
+    // `cpu` restores the host CPU and all of its features, which is the default. Applies to
+    // functions compiled after the call, like `set_optimization_level`.
+    void
+    set_target_cpu (std::string_view cpu, std::string_view features = "")
+    {
+      m_impl->set_target_cpu (cpu, features);
+    }
+
+    // Lets the vectorizer call the vector variants of math functions (such as `sqrt` and `exp`)
+    // from the given library. The library must be loaded into the process before code which
+    // uses it is linked. Applies to functions compiled after the call, like
+    // `set_optimization_level`. Throws `ir_exception` if the library is not available for the
+    // target (libmvec requires x86-64, and svml requires x86).
+    void
+    set_vector_library (octave_jit_vector_library lib)
+    {
+      m_impl->set_vector_library (lib);
+    }
+
+    // Persist compiled objects in `directory` so they can be reused across sessions. If
+    // `max_size` is nonzero, the least recently used objects are evicted to stay within it.
+    void
+    enable_object_cache (std::string_view directory, std::size_t max_size = 0)
+    {
+      m_impl->enable_object_cache (directory, max_size);
+    }
+
+    void
+    disable_object_cache (void)
+    {
+      m_impl->disable_object_cache ();
+    }
+
+    // Registers code compiled after the call with profilers and debuggers (perf and GDB), so
+    // that they can name the generated functions. This cannot be undone, and it should be
+    // called before any functions are compiled.
+    void
+    enable_jit_registration (void)
+    {
+      m_impl->enable_jit_registration ();
+    }
+
+    // Emits debug info for functions compiled after the call which records, for each machine
+    // instruction, the static IR instruction it came from. Debuggers and profilers which read
+    // DWARF (see `enable_jit_registration`) can then attribute code within a function.
+    void
+    enable_debug_info (bool enable = true)
+    {
+      m_impl->enable_debug_info (enable);
+    }
+
+    // Maps an address in code compiled with debug info back to the static IR instruction which
+    // generated it. Returns nullopt if the address is not in such code, or if it is in code
+    // added by the compiler, such as the loop of a map entry point.
+    [[nodiscard]]
+    std::optional<octave_jit_source_location>
+    find_source_location (const void *address) const
+    {
+      return m_impl->find_source_location (address);
+    }
+
   private:
     template <typename T, typename ...Args>
     explicit
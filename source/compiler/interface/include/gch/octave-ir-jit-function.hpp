@@ -0,0 +1,131 @@
+/** octave-ir-jit-function.hpp
+ * A typed handle to a compiled function.
+ *
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef OCTAVE_IR_COMPILER_OCTAVE_IR_JIT_FUNCTION_HPP
+#define OCTAVE_IR_COMPILER_OCTAVE_IR_JIT_FUNCTION_HPP
+
+#include "ir-error.hpp"
+#include "ir-static-function.hpp"
+#include "ir-type.hpp"
+#include "ir-type-util.hpp"
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <type_traits>
+
+namespace gch
+{
+
+  class octave_jit_compiler;
+
+  template <typename Signature>
+  class octave_jit_function;
+
+  // The signature is checked once, when the handle is created. Calls go straight through the
+  // native pointer.
+  template <typename R, typename ...Args>
+  class octave_jit_function<R (Args...)>
+  {
+    static_assert (std::conjunction_v<is_ir_type<Args>...>,
+                   "Each argument type must have a corresponding IR type.");
+
+    static_assert (std::is_void_v<R> || is_ir_type_v<R>,
+                   "The result type must be void or have a corresponding IR type.");
+
+  public:
+    using pointer = R (*) (Args...);
+
+    octave_jit_function            (void)                           = default;
+    octave_jit_function            (const octave_jit_function&)     = default;
+    octave_jit_function            (octave_jit_function&&) noexcept = default;
+    octave_jit_function& operator= (const octave_jit_function&)     = default;
+    octave_jit_function& operator= (octave_jit_function&&) noexcept = default;
+    ~octave_jit_function           (void)                           = default;
+
+    // Throws `ir_exception` if the signature does not match that of `func`.
+    octave_jit_function (const ir_static_function& func, void *address)
+      : m_pointer (reinterpret_cast<pointer> (address))
+    {
+      check_signature (func);
+    }
+
+    R
+    operator() (Args... args) const
+    {
+      return m_pointer (args...);
+    }
+
+    [[nodiscard]]
+    pointer
+    get (void) const noexcept
+    {
+      return m_pointer;
+    }
+
+    [[nodiscard]]
+    explicit
+    operator bool (void) const noexcept
+    {
+      return m_pointer != nullptr;
+    }
+
+    static
+    void
+    check_signature (const ir_static_function& func)
+    {
+      auto num_args = static_cast<std::size_t> (std::distance (func.args_begin (),
+                                                               func.args_end ()));
+      if (num_args != sizeof...(Args))
+      {
+        throw ir_exception ("Function `" + std::string (func.get_name ()) + "` takes "
+                            + std::to_string (num_args) + " arguments, but the signature has "
+                            + std::to_string (sizeof...(Args)) + ".");
+      }
+
+      const std::array<ir_type, sizeof...(Args)> arg_types { ir_type_v<Args>... };
+      auto arg_it = func.args_begin ();
+      for (std::size_t i = 0; i < arg_types.size (); ++i, ++arg_it)
+      {
+        ir_type ty = func.get_type (*arg_it);
+        if (ty != arg_types[i])
+        {
+          throw ir_exception ("Argument " + std::to_string (i) + " of function `"
+                              + std::string (func.get_name ()) + "` has type `" + get_name (ty)
+                              + "`, but the signature has `" + get_name (arg_types[i]) + "`.");
+        }
+      }
+
+      // Only the first return is passed back.
+      ir_type ret_ty = func.has_returns () ? func.get_type (*func.returns_begin ())
+                                           : ir_type_v<void>;
+      if (ret_ty != ir_type_v<R>)
+      {
+        throw ir_exception ("Function `" + std::string (func.get_name ()) + "` returns `"
+                            + get_name (ret_ty) + "`, but the signature has `"
+                            + get_name (ir_type_v<R>) + "`.");
+      }
+    }
+
+  private:
+    friend class octave_jit_compiler;
+
+    // For callers which have already checked the signature.
+    explicit
+    octave_jit_function (void *address) noexcept
+      : m_pointer (reinterpret_cast<pointer> (address))
+    { }
+
+    pointer m_pointer = nullptr;
+  };
+
+}
+
+#endif // OCTAVE_IR_COMPILER_OCTAVE_IR_JIT_FUNCTION_HPP
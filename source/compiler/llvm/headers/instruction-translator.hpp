@@ -63,20 +63,11 @@ namespace gch
     static
     llvm::Value *
     translate (const ir_static_instruction& instr,
-               llvm_ir_builder_type&        builder,
+               llvm_ir_builder_type&,
                llvm_value_map&              value_map)
     {
-      const ir_static_def& def = instr.get_def ();
-      llvm::Value& var = value_map[def];
-
-      llvm::Argument& llvm_arg = value_map.get_llvm_argument (def.get_variable_id ());
-
-      builder.CreateStore (&llvm_arg, &var);
-
-      return builder.CreateLoad (
-        &value_map.get_llvm_type (def),
-        &var,
-        value_map.get_variable_name (def));
+      // The static IR is in SSA form, so the argument is used as the def directly.
+      return &value_map.get_llvm_argument (instr.get_def ().get_variable_id ());
     }
   };
 
@@ -134,18 +125,11 @@ namespace gch
     static
     llvm::Value *
     translate (const ir_static_instruction& instr,
-               llvm_ir_builder_type&        builder,
+               llvm_ir_builder_type&,
                llvm_value_map&              value_map)
     {
-      const ir_static_def& def = instr.get_def ();
-      llvm::Value& var = value_map[def];
-
-      builder.CreateStore (&value_map[instr[0]], &var);
-
-      return builder.CreateLoad (
-        &value_map.get_llvm_type (def),
-        &var,
-        value_map.get_variable_name (def));
+      // No code is emitted; the def is just another name for the assigned value.
+      return &value_map[instr[0]];
     }
   };
 
@@ -479,18 +463,30 @@ namespace gch
         arg_types,
         ext_func.is_variadic ());
 
-      optional_ref<llvm::Function> func {
-        value_map.get_external_function (ext_func.get_name (), llvm_function_ty)
-      };
+      // Calls between compiled functions resolve within the JIT rather than the host process.
+      // Known math functions become intrinsics, which can be folded and vectorized.
+      optional_ref<llvm::Function> func;
+      if (ext_func.get_linkage () == ir_external_function_info::linkage::jit)
+        func = &value_map.get_jit_function (ext_func.get_name (), llvm_function_ty);
+      else if (! (func = value_map.get_math_intrinsic (ext_func.get_name (), llvm_function_ty)))
+      {
+        func = value_map.get_external_function (ext_func.get_name (), llvm_function_ty,
+                                                ext_func.get_attributes ());
+      }
 
       llvm::SmallVector<llvm::Value *> args;
       std::transform (std::next (instr.begin ()), instr.end (), std::back_inserter (args),
                       [&](const ir_static_operand& op) { return &value_map[op]; });
 
-      return builder.CreateCall (
+      llvm::CallInst *call = builder.CreateCall (
         func.get_pointer (),
         args,
         instr.maybe_get_def () >>= [&](auto def) { return value_map.get_variable_name (def); });
+
+      // The call site is annotated too, in case the declaration is shared with calls which
+      // were not.
+      add_llvm_attributes (*call, ext_func.get_attributes ());
+      return call;
     }
   };
 
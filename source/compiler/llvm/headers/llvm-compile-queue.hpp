@@ -0,0 +1,77 @@
+/** llvm-compile-queue.hpp
+ * A bounded priority queue of compilation jobs serviced by a pool of worker threads.
+ *
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef OCTAVE_IR_COMPILER_LLVM_LLVM_COMPILE_QUEUE_HPP
+#define OCTAVE_IR_COMPILER_LLVM_LLVM_COMPILE_QUEUE_HPP
+
+#include "gch/octave-ir-compile-handle.hpp"
+#include "ir-static-function.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gch
+{
+
+  class llvm_compile_queue
+  {
+  public:
+    using compile_function = std::function<void * (const ir_static_function&)>;
+
+    llvm_compile_queue            (void)                          = delete;
+    llvm_compile_queue            (const llvm_compile_queue&)     = delete;
+    llvm_compile_queue            (llvm_compile_queue&&) noexcept = delete;
+    llvm_compile_queue& operator= (const llvm_compile_queue&)     = delete;
+    llvm_compile_queue& operator= (llvm_compile_queue&&) noexcept = delete;
+    ~llvm_compile_queue           (void);
+
+    llvm_compile_queue (compile_function compile, std::size_t num_workers, std::size_t capacity);
+
+    // Blocks while the queue is at capacity.
+    octave_jit_compile_handle
+    submit (ir_static_function&& func, int priority);
+
+  private:
+    struct job
+    {
+      int                                       priority;
+      std::uint64_t                             sequence;
+      ir_static_function                        function;
+      std::shared_ptr<octave_jit_compile_state> state;
+    };
+
+    static
+    bool
+    compare_jobs (const job& lhs, const job& rhs) noexcept;
+
+    void
+    run_worker (void);
+
+    compile_function         m_compile;
+    std::size_t              m_capacity;
+
+    std::mutex               m_mutex;
+    std::condition_variable  m_not_empty;
+    std::condition_variable  m_not_full;
+    std::vector<job>         m_jobs;
+    std::uint64_t            m_next_sequence = 0;
+    bool                     m_stopping      = false;
+
+    std::vector<std::thread> m_workers;
+  };
+
+}
+
+#endif // OCTAVE_IR_COMPILER_LLVM_LLVM_COMPILE_QUEUE_HPP
@@ -0,0 +1,140 @@
+/** llvm-compile-stats.hpp
+ * Timers and counters for the phases of compilation.
+ *
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef OCTAVE_IR_COMPILER_LLVM_LLVM_COMPILE_STATS_HPP
+#define OCTAVE_IR_COMPILER_LLVM_LLVM_COMPILE_STATS_HPP
+
+#include "llvm-common.hpp"
+
+#include "gch/octave-ir-compiler-interface.hpp"
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/Support/MemoryBuffer.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gch
+{
+
+  // The phases of a module all run on the thread which materializes it, nested within
+  // `ast_layer::emit`. A `module_scope` on that thread collects them, so the phases deeper in
+  // the pipeline can record themselves without knowing which module they belong to.
+  class llvm_compile_stats
+  {
+  public:
+    using clock         = std::chrono::steady_clock;
+    using function_refs = octave_jit_compiler_impl::function_refs;
+
+    class module_scope
+    {
+    public:
+      module_scope            (void)                    = delete;
+      module_scope            (const module_scope&)     = delete;
+      module_scope            (module_scope&&) noexcept = delete;
+      module_scope& operator= (const module_scope&)     = delete;
+      module_scope& operator= (module_scope&&) noexcept = delete;
+
+      module_scope (llvm_compile_stats& stats, const function_refs& funcs);
+
+      // Commits the record to the statistics.
+      ~module_scope (void);
+
+      void
+      set_cached (void) noexcept;
+
+    private:
+      struct event
+      {
+        octave_jit_compile_phase phase;
+        clock::time_point        start;
+        clock::time_point        end;
+      };
+
+      friend class llvm_compile_stats;
+
+      llvm_compile_stats&     m_stats;
+      module_scope           *m_outer;
+      octave_jit_module_stats m_record;
+      std::vector<event>      m_events;
+    };
+
+    llvm_compile_stats            (const llvm_compile_stats&)     = delete;
+    llvm_compile_stats            (llvm_compile_stats&&) noexcept = delete;
+    llvm_compile_stats& operator= (const llvm_compile_stats&)     = delete;
+    llvm_compile_stats& operator= (llvm_compile_stats&&) noexcept = delete;
+    ~llvm_compile_stats           (void)                          = default;
+
+    llvm_compile_stats (void);
+
+    void
+    enable (bool enable) noexcept;
+
+    [[nodiscard]]
+    bool
+    is_enabled (void) const noexcept;
+
+    void
+    reset (void);
+
+    [[nodiscard]]
+    octave_jit_compile_stats
+    get (void) const;
+
+    [[nodiscard]]
+    std::string
+    get_chrome_trace (void) const;
+
+    // Whether a module is being measured on this thread. Check this before reading the clock.
+    [[nodiscard]]
+    static
+    bool
+    is_active (void) noexcept;
+
+    // Records a phase of the module being measured on this thread, if there is one.
+    static
+    void
+    record (octave_jit_compile_phase phase, clock::time_point start, clock::time_point end);
+
+    // Adds the size of the executable sections of the object.
+    static
+    void
+    record_code (const llvm::MemoryBuffer& obj);
+
+  private:
+    struct trace_event
+    {
+      octave_jit_compile_phase phase;
+      std::size_t              module;
+      clock::time_point        start;
+      clock::time_point        end;
+      std::thread::id          thread;
+    };
+
+    void
+    commit (module_scope& scope);
+
+    std::atomic<bool>        m_enabled { false };
+    mutable std::mutex       m_mutex;
+    clock::time_point        m_epoch;
+    octave_jit_compile_stats m_stats;
+    std::vector<trace_event> m_events;
+  };
+
+}
+
+#endif // OCTAVE_IR_COMPILER_LLVM_LLVM_COMPILE_STATS_HPP
@@ -0,0 +1,84 @@
+/** llvm-debug-map.hpp
+ * Maps addresses in emitted code back to static IR instructions.
+ *
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef OCTAVE_IR_COMPILER_LLVM_LLVM_DEBUG_MAP_HPP
+#define OCTAVE_IR_COMPILER_LLVM_LLVM_DEBUG_MAP_HPP
+
+#include "llvm-common.hpp"
+
+#include "gch/octave-ir-compiler-interface.hpp"
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/ExecutionEngine/JITEventListener.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gch
+{
+
+  class ir_static_function;
+
+  // Reads the line tables of objects loaded by RuntimeDyld. Functions are translated with the
+  // index of the block as the line, and the index of the instruction as the column, in a file
+  // named after the static function (see `create_llvm_module`).
+  class llvm_debug_map
+    : public llvm::JITEventListener
+  {
+  public:
+    // Block names are only known from the static function, so they are recorded when the
+    // function is emitted.
+    void
+    add_function (const ir_static_function& func);
+
+    [[nodiscard]]
+    std::optional<octave_jit_source_location>
+    find (std::uint64_t address) const;
+
+    void
+    notifyObjectLoaded (ObjectKey key, const llvm::object::ObjectFile& obj,
+                        const llvm::RuntimeDyld::LoadedObjectInfo& info) override;
+
+    void
+    notifyFreeingObject (ObjectKey key) override;
+
+  private:
+    struct row
+    {
+      std::uint64_t address;
+      std::size_t   file;
+      std::uint32_t line;
+      std::uint32_t column;
+    };
+
+    // The code of a single function symbol.
+    struct code_range
+    {
+      std::uint64_t            end;
+      ObjectKey                key;
+      std::vector<std::string> files;
+      std::vector<row>         rows;
+    };
+
+    mutable std::mutex                                        m_mutex;
+    std::map<std::uint64_t, code_range>                       m_ranges;
+    std::unordered_map<std::string, std::vector<std::string>> m_block_names;
+  };
+
+}
+
+#endif // OCTAVE_IR_COMPILER_LLVM_LLVM_DEBUG_MAP_HPP
@@ -9,14 +9,24 @@
 #define OCTAVE_IR_COMPILER_LLVM_LLVM_INTERFACE_HPP
 
 #include "llvm-common.hpp"
+#include "llvm-compile-stats.hpp"
+#include "llvm-debug-map.hpp"
+#include "llvm-jit-events.hpp"
+#include "llvm-memory-manager.hpp"
+#include "llvm-object-cache.hpp"
+#include "llvm-optimizer.hpp"
+#include "llvm-runtime-library.hpp"
 #include "llvm-version.hpp"
 
+#include "gch/octave-ir-compiler-llvm.hpp"
+
+#include <gch/nonnull_ptr.hpp>
+
 GCH_DISABLE_WARNINGS_MSVC
 
 #include <llvm/ADT/StringRef.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 #include <llvm/ExecutionEngine/JITSymbol.h>
-#include <llvm/ExecutionEngine/SectionMemoryManager.h>
 #include <llvm/ExecutionEngine/Orc/CompileUtils.h>
 #include <llvm/ExecutionEngine/Orc/Core.h>
 #include <llvm/ExecutionEngine/Orc/EPCIndirectionUtils.h>
@@ -24,7 +34,9 @@ GCH_DISABLE_WARNINGS_MSVC
 #include <llvm/ExecutionEngine/Orc/IRCompileLayer.h>
 #include <llvm/ExecutionEngine/Orc/IRTransformLayer.h>
 #include <llvm/ExecutionEngine/Orc/Layer.h>
+#include <llvm/ExecutionEngine/Orc/LazyReexports.h>
 #include <llvm/ExecutionEngine/Orc/Mangling.h>
+#include <llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h>
 #include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/DataLayout.h>
@@ -39,17 +51,45 @@ GCH_DISABLE_WARNINGS_MSVC
 
 GCH_ENABLE_WARNINGS_MSVC
 
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
 namespace gch
 {
 
   class ir_static_function;
   class llvm_interface;
 
+  // The form in which functions are emitted.
+  enum class llvm_entry_kind
+  {
+    scalar,
+    map,    // Applies the function elementwise over arrays.
+    boxed,  // Takes the arguments and the result through untyped pointers.
+  };
+
+  // The name of the symbol for the entry point of the given kind.
+  [[nodiscard]]
+  std::string
+  get_entry_name (std::string_view name, llvm_entry_kind kind);
+
+  // Calls to functions in `runtime_library` are declared with their registered signatures.
   llvm::orc::ThreadSafeModule
-  create_llvm_module (const llvm::DataLayout& data_layout, const ir_static_function& func);
+  create_llvm_module (const llvm::DataLayout& data_layout,
+                      const std::vector<nonnull_ptr<const ir_static_function>>& funcs,
+                      llvm_entry_kind kind = llvm_entry_kind::scalar, bool debug_info = false,
+                      const llvm_runtime_library *runtime_library = nullptr);
 
   class llvm_interface
   {
+  public:
+    using function_refs = std::vector<nonnull_ptr<const ir_static_function>>;
+
+  private:
     using resource_tracker_type = llvm::orc::JITDylib;
 
     class ast_layer
@@ -57,7 +97,9 @@ namespace gch
       class materialization_unit : public llvm::orc::MaterializationUnit
       {
       public:
-        materialization_unit (ast_layer& ast_layer, const ir_static_function& func);
+        materialization_unit (ast_layer& ast_layer, function_refs funcs, llvm_entry_kind kind);
+
+        materialization_unit (ast_layer& ast_layer, std::unique_ptr<ir_static_function> func);
 
         [[nodiscard]]
         llvm::StringRef
@@ -70,41 +112,65 @@ namespace gch
         void
         discard (const resource_tracker_type&, const llvm::orc::SymbolStringPtr&) override;
 
-        ast_layer&                m_ast_layer;
-        const ir_static_function& m_function;
+        ast_layer&                          m_ast_layer;
+        std::unique_ptr<ir_static_function> m_owned_function;
+        function_refs                       m_functions;
+        llvm_entry_kind                     m_kind;
       };
 
     public:
-      ast_layer (llvm::orc::IRLayer& base_layer, const llvm::DataLayout& data_layout,
-                 bool printing = false);
+      ast_layer (const llvm_optimizer& optimizer, llvm::orc::ObjectLayer& object_layer,
+                 llvm_object_cache& object_cache, llvm_compile_stats& compile_stats,
+                 const llvm_runtime_library& runtime_library,
+                 const llvm::DataLayout& data_layout, bool printing = false);
 
+      // The functions must outlive materialization. They are emitted together as one module.
       llvm::Error
-      add (const ir_static_function& func, llvm::orc::ResourceTrackerSP res_tracker);
+      add (function_refs funcs, llvm::orc::ResourceTrackerSP res_tracker,
+           llvm_entry_kind kind = llvm_entry_kind::scalar);
+
+      llvm::Error
+      add (std::unique_ptr<ir_static_function> func, llvm::orc::ResourceTrackerSP res_tracker);
 
       void
       emit (std::unique_ptr<llvm::orc::MaterializationResponsibility> resp,
-            const ir_static_function& func);
+            const function_refs& funcs, llvm_entry_kind kind);
 
       llvm::orc::SymbolFlagsMap
-      get_interface (const ir_static_function& func);
+      get_interface (const function_refs& funcs, llvm_entry_kind kind);
 
+      // The settings may change while other threads are emitting.
       void
       enable_printing (bool printing);
 
+      // Block names are recorded in `debug_map`, if it is not null.
+      void
+      enable_debug_info (bool debug_info, llvm_debug_map *debug_map);
+
     private:
-      llvm::orc::IRLayer&     m_base_layer;
-      const llvm::DataLayout& m_data_layout;
-      bool                    m_printing_enabled;
+      const llvm_optimizer&         m_optimizer;
+      llvm::orc::ObjectLayer&       m_object_layer;
+      llvm_object_cache&            m_object_cache;
+      llvm_compile_stats&           m_compile_stats;
+      const llvm_runtime_library&   m_runtime_library;
+      const llvm::DataLayout&       m_data_layout;
+      std::atomic<bool>             m_printing_enabled;
+      std::atomic<bool>             m_debug_info_enabled { false };
+      std::atomic<llvm_debug_map *> m_debug_map          { nullptr };
+
+      // Keeps modules printed by concurrent emissions from interleaving.
+      std::mutex                    m_print_mutex;
     };
 
   public:
-    using object_layer_type   = llvm::orc::RTDyldObjectLinkingLayer;
+    using object_layer_type   = llvm::orc::ObjectLayer;
     using compile_layer_type  = llvm::orc::IRCompileLayer;
 
     llvm_interface (std::unique_ptr<llvm::orc::ExecutionSession> execution_session,
                     std::unique_ptr<llvm::orc::EPCIndirectionUtils> epc_indirection_utils,
                     llvm::orc::JITTargetMachineBuilder&& jit_builder,
-                    const llvm::DataLayout& data_layout);
+                    const llvm::DataLayout& data_layout,
+                    octave_jit_llvm_linker linker);
 
     llvm_interface            (void)                      = delete;
     llvm_interface            (const llvm_interface&)     = delete;
@@ -126,43 +192,177 @@ namespace gch
     llvm::Error
     add_ast (const ir_static_function& func, llvm::orc::ResourceTrackerSP res_tracker = nullptr);
 
+    llvm::Error
+    add_ast (function_refs funcs, llvm::orc::ResourceTrackerSP res_tracker = nullptr);
+
+    // Defines the entry point of the given kind for the function (see `get_entry_name`). The
+    // scalar entry point is only emitted internally, to be inlined into the wrapper.
+    llvm::Error
+    add_entry_ast (const ir_static_function& func, llvm_entry_kind kind,
+                   llvm::orc::ResourceTrackerSP res_tracker);
+
+    // Defines a stub for the function in the main dylib. The function is only translated and
+    // compiled once the stub is first called. The body is tracked by `body_tracker`, which must
+    // belong to the lazy dylib.
+    llvm::Error
+    add_lazy_ast (ir_static_function&& func,
+                  llvm::orc::ResourceTrackerSP stub_tracker = nullptr,
+                  llvm::orc::ResourceTrackerSP body_tracker = nullptr);
+
+    // Code added with its own tracker can be freed independently of other code.
+    [[nodiscard]]
+    llvm::orc::ResourceTrackerSP
+    create_resource_tracker (void);
+
+    [[nodiscard]]
+    llvm::orc::ResourceTrackerSP
+    create_lazy_resource_tracker (void);
+
+    // Removes the symbols and frees the memory of everything added with the tracker.
+    llvm::Error
+    remove (llvm::orc::ResourceTrackerSP res_tracker);
+
+    // Translates, optimizes, and compiles the functions into one relocatable object, without
+    // adding them to the JIT. The id of the configuration it was compiled for is written to
+    // `configuration_id`.
+    llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>>
+    compile_object (const function_refs& funcs, std::string& configuration_id);
+
+    // Links an object produced by `compile_object`, possibly in another process, into the main
+    // dylib. Nothing is compiled.
+    llvm::Error
+    add_object (std::unique_ptr<llvm::MemoryBuffer> obj, llvm::orc::ResourceTrackerSP res_tracker);
+
+    // Defines `alias` in the main dylib as another name for the symbol `target`, which must also
+    // be defined there.
+    llvm::Error
+    add_alias (std::string_view alias, std::string_view target,
+               llvm::orc::ResourceTrackerSP res_tracker);
+
+    // Defines `name` in the main dylib as a stub which jumps to `target`. The stub is never
+    // freed. Returns its address.
+    llvm::Expected<std::uint64_t>
+    create_redirect (std::string_view name, std::uint64_t target);
+
+    // Atomically points the stub for `name` at `target`.
+    llvm::Error
+    update_redirect (std::string_view name, std::uint64_t target);
+
+    // Defines the function as an absolute symbol in the main dylib, so that it is found before
+    // the process is searched. Fails if the name is already defined.
+    llvm::Error
+    add_runtime_function (octave_jit_runtime_function func);
+
     llvm::Expected<llvm::JITEvaluatedSymbol>
     find_symbol (std::string_view name);
 
+    // Looks up all of the symbols at once, so that they are materialized together.
+    llvm::Expected<std::vector<llvm::JITEvaluatedSymbol>>
+    find_symbols (const std::vector<std::string_view>& names);
+
     static
     llvm::Expected<std::unique_ptr<llvm_interface>>
-    create (void);
+    create (octave_jit_llvm_linker linker);
 
     void
     enable_printing (bool printing = true);
 
-  private:
-    static
-    std::unique_ptr<llvm::SectionMemoryManager>
-    create_memory_manager (void);
+    void
+    set_optimization_level (octave_jit_optimization_level level);
 
-    static
-    std::unique_ptr<llvm::orc::ConcurrentIRCompiler>
-    create_compiler (llvm::orc::JITTargetMachineBuilder&& jit_builder);
+    void
+    append_passes (std::string_view pipeline);
 
-    static
-    llvm::Expected<llvm::orc::ThreadSafeModule>
-    optimize_module (llvm::orc::ThreadSafeModule module,
-                     const llvm::orc::MaterializationResponsibility& resp);
+    void
+    clear_passes (void);
+
+    void
+    set_target_cpu (std::string_view cpu, std::string_view features);
+
+    void
+    set_vector_library (octave_jit_vector_library lib);
+
+    // Identifies the target and optimization settings which compiled code depends on.
+    [[nodiscard]]
+    std::string
+    get_configuration_id (void) const;
+
+    void
+    enable_object_cache (std::string_view directory, std::size_t max_size);
+
+    void
+    disable_object_cache (void);
+
+    // Registers objects emitted after the call with the GDB JIT interface, and writes the
+    // locations of their functions to a perf map (and to a jitdump file, if LLVM was built with
+    // perf support). Only ELF objects are registered with GDB under JITLink, and only if the
+    // registration entry point can be found in the process.
+    void
+    enable_jit_registration (void);
+
+    // Source locations can only be found for objects linked by RuntimeDyld. Debug info is
+    // still emitted under JITLink, for use by debuggers.
+    void
+    enable_debug_info (bool enable);
+
+    [[nodiscard]]
+    std::optional<octave_jit_source_location>
+    find_source_location (std::uint64_t address) const;
+
+    // Only memory allocated for RuntimeDyld is reported.
+    [[nodiscard]]
+    octave_jit_memory_stats
+    get_memory_stats (void) const;
+
+    void
+    enable_statistics (bool enable);
+
+    void
+    reset_statistics (void);
+
+    [[nodiscard]]
+    octave_jit_compile_stats
+    get_statistics (void) const;
+
+    [[nodiscard]]
+    std::string
+    get_chrome_trace (void) const;
+
+  private:
+    std::unique_ptr<object_layer_type>
+    create_object_layer (octave_jit_llvm_linker linker);
+
+    std::unique_ptr<llvm_memory_manager>
+    create_memory_manager (void);
 
     [[noreturn]] static
     void
     handle_lazy_call_through_error (void);
 
-    std::unique_ptr<llvm::orc::ExecutionSession>    m_execution_session;
-    std::unique_ptr<llvm::orc::EPCIndirectionUtils> m_epc_indirection_utils;
-    const llvm::DataLayout                          m_data_layout;
-    llvm::orc::MangleAndInterner                    m_mangler;
-    object_layer_type                               m_object_layer;
-    compile_layer_type                              m_compile_layer;
-    llvm::orc::IRTransformLayer                     m_optimization_layer;
-    ast_layer                                       m_ast_layer;
-    llvm::orc::JITDylib&                            m_jit_dylib;
+    std::unique_ptr<llvm::orc::ExecutionSession>     m_execution_session;
+    std::unique_ptr<llvm::orc::EPCIndirectionUtils>  m_epc_indirection_utils;
+    std::unique_ptr<llvm::orc::IndirectStubsManager> m_indirect_stubs_manager;
+    std::unique_ptr<llvm::orc::IndirectStubsManager> m_redirect_stubs_manager;
+    const llvm::DataLayout                           m_data_layout;
+    llvm::orc::MangleAndInterner                     m_mangler;
+    llvm_optimizer                                   m_optimizer;
+    llvm_object_cache                                m_object_cache;
+    llvm_slab_allocator                              m_slab_allocator;
+    octave_jit_llvm_linker                           m_linker;
+
+    // Guards the listeners and plugins, which are created on first use.
+    mutable std::mutex                               m_listener_mutex;
+    std::unique_ptr<llvm_perf_map>                   m_perf_map;
+    std::unique_ptr<llvm_perf_map_listener>          m_perf_map_listener;
+    std::unique_ptr<llvm_debug_map>                  m_debug_map;
+    std::unique_ptr<object_layer_type>               m_object_layer;
+    compile_layer_type                               m_compile_layer;
+    llvm::orc::IRTransformLayer                      m_optimization_layer;
+    llvm_compile_stats                               m_compile_stats;
+    llvm_runtime_library                             m_runtime_library;
+    ast_layer                                        m_ast_layer;
+    llvm::orc::JITDylib&                             m_jit_dylib;
+    llvm::orc::JITDylib&                             m_lazy_jit_dylib;
   };
 
 }
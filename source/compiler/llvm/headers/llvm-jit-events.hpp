@@ -0,0 +1,101 @@
+/** llvm-jit-events.hpp
+ * Reports the locations of emitted functions to perf.
+ *
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef OCTAVE_IR_COMPILER_LLVM_LLVM_JIT_EVENTS_HPP
+#define OCTAVE_IR_COMPILER_LLVM_LLVM_JIT_EVENTS_HPP
+
+#include "llvm-common.hpp"
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/ExecutionEngine/JITEventListener.h>
+#include <llvm/ExecutionEngine/JITLink/JITLink.h>
+#include <llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+
+namespace gch
+{
+
+  // Appends lines of the form `<start> <size> <name>` to `/tmp/perf-<pid>.map`, which perf
+  // reads to name addresses in anonymous executable memory. Entries are never removed, so a
+  // later entry for a reused address takes precedence.
+  class llvm_perf_map
+  {
+  public:
+    llvm_perf_map            (const llvm_perf_map&)     = delete;
+    llvm_perf_map            (llvm_perf_map&&) noexcept = delete;
+    llvm_perf_map& operator= (const llvm_perf_map&)     = delete;
+    llvm_perf_map& operator= (llvm_perf_map&&) noexcept = delete;
+    ~llvm_perf_map           (void)                     = default;
+
+    llvm_perf_map (void);
+
+    void
+    add (std::uint64_t address, std::uint64_t size, llvm::StringRef name);
+
+    void
+    flush (void);
+
+  private:
+    std::mutex    m_mutex;
+    std::ofstream m_stream;
+  };
+
+  // Reports the functions in objects loaded by RuntimeDyld.
+  class llvm_perf_map_listener
+    : public llvm::JITEventListener
+  {
+  public:
+    explicit
+    llvm_perf_map_listener (llvm_perf_map& perf_map);
+
+    void
+    notifyObjectLoaded (ObjectKey key, const llvm::object::ObjectFile& obj,
+                        const llvm::RuntimeDyld::LoadedObjectInfo& info) override;
+
+  private:
+    llvm_perf_map& m_perf_map;
+  };
+
+  // Reports the functions in objects linked by JITLink.
+  class llvm_perf_map_plugin
+    : public llvm::orc::ObjectLinkingLayer::Plugin
+  {
+  public:
+    explicit
+    llvm_perf_map_plugin (llvm_perf_map& perf_map);
+
+    void
+    modifyPassConfig (llvm::orc::MaterializationResponsibility& resp,
+                      llvm::jitlink::LinkGraph& graph,
+                      llvm::jitlink::PassConfiguration& config) override;
+
+    llvm::Error
+    notifyFailed (llvm::orc::MaterializationResponsibility& resp) override;
+
+    llvm::Error
+    notifyRemovingResources (llvm::orc::ResourceKey key) override;
+
+    void
+    notifyTransferringResources (llvm::orc::ResourceKey dst_key,
+                                 llvm::orc::ResourceKey src_key) override;
+
+  private:
+    llvm_perf_map& m_perf_map;
+  };
+
+}
+
+#endif // OCTAVE_IR_COMPILER_LLVM_LLVM_JIT_EVENTS_HPP
@@ -0,0 +1,38 @@
+/** llvm-math-intrinsics.hpp
+ * Recognizes calls to C math functions which LLVM has intrinsics for.
+ *
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef OCTAVE_IR_COMPILER_LLVM_LLVM_MATH_INTRINSICS_HPP
+#define OCTAVE_IR_COMPILER_LLVM_LLVM_MATH_INTRINSICS_HPP
+
+#include "llvm-common.hpp"
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Intrinsics.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <optional>
+#include <string_view>
+
+namespace gch
+{
+
+  // Returns the intrinsic which computes the math function `name` for the prototype at the call
+  // site, if there is one. The arguments and the result must all have the floating-point type
+  // of the function, as in `double sqrt (double)` or `float sqrtf (float)`. Intrinsics can be
+  // constant folded and vectorized, but unlike the library functions they never set `errno`.
+  [[nodiscard]]
+  std::optional<llvm::Intrinsic::ID>
+  find_math_intrinsic (std::string_view name, const llvm::FunctionType& prototype);
+
+}
+
+#endif // OCTAVE_IR_COMPILER_LLVM_LLVM_MATH_INTRINSICS_HPP
@@ -0,0 +1,191 @@
+/** llvm-memory-manager.hpp
+ * A memory manager for the object layer which carves sections out of large shared slabs.
+ *
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef OCTAVE_IR_COMPILER_LLVM_LLVM_MEMORY_MANAGER_HPP
+#define OCTAVE_IR_COMPILER_LLVM_LLVM_MEMORY_MANAGER_HPP
+
+#include "llvm-common.hpp"
+
+#include "gch/octave-ir-compiler-interface.hpp"
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/ExecutionEngine/RTDyldMemoryManager.h>
+#include <llvm/Support/Memory.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gch
+{
+
+  // Shared by all of the memory managers of an object layer. Memory is mapped in slabs, and
+  // handed out in page-aligned ranges so that each range can be protected independently.
+  // Ranges are returned to a free list when their object is removed, and slabs which become
+  // entirely free are unmapped (except for one per section kind).
+  //
+  // Objects never share a page, since the pages of an object are protected as soon as it is
+  // finalized, and executable pages may not be made writable again while other threads run
+  // them. Each object therefore occupies at least one page for each kind of section it has,
+  // which dominates the footprint of many small functions (see `bench-linker`).
+  class llvm_slab_allocator
+  {
+  public:
+    enum class section_kind
+    {
+      code,
+      rodata,
+      data,
+    };
+
+    static constexpr std::size_t num_section_kinds = 3;
+
+    struct range
+    {
+      std::uint8_t *base = nullptr;
+      std::size_t   size = 0;
+    };
+
+    llvm_slab_allocator            (const llvm_slab_allocator&)     = delete;
+    llvm_slab_allocator            (llvm_slab_allocator&&) noexcept = delete;
+    llvm_slab_allocator& operator= (const llvm_slab_allocator&)     = delete;
+    llvm_slab_allocator& operator= (llvm_slab_allocator&&) noexcept = delete;
+    ~llvm_slab_allocator           (void);
+
+    explicit
+    llvm_slab_allocator (std::size_t slab_size = 4 * 1024 * 1024);
+
+    // Returns a readable and writable range of at least `size` bytes, rounded up to a whole
+    // number of pages. Returns an empty range if the memory could not be mapped.
+    [[nodiscard]]
+    range
+    allocate (section_kind kind, std::size_t size);
+
+    // The range must be page-aligned and must lie within a range returned by `allocate`.
+    void
+    deallocate (section_kind kind, range r);
+
+    void
+    add_used (section_kind kind, std::size_t size);
+
+    void
+    remove_used (section_kind kind, std::size_t size);
+
+    [[nodiscard]]
+    std::size_t
+    get_page_size (void) const noexcept;
+
+    [[nodiscard]]
+    octave_jit_memory_stats
+    get_stats (void) const;
+
+  private:
+    struct pool
+    {
+      std::vector<llvm::sys::MemoryBlock>   slabs;
+      std::map<std::uint8_t *, std::size_t> free_ranges;
+      std::size_t                           reserved  = 0;
+      std::size_t                           allocated = 0;
+      std::size_t                           used      = 0;
+    };
+
+    [[nodiscard]]
+    octave_jit_memory_usage
+    get_usage (const pool& p) const;
+
+    // Unmaps the slab if the free range covers all of it.
+    void
+    release_if_unused (pool& p, std::map<std::uint8_t *, std::size_t>::iterator free_range);
+
+    [[nodiscard]]
+    pool&
+    get_pool (section_kind kind) noexcept;
+
+    std::size_t                         m_page_size;
+    std::size_t                         m_slab_size;
+    mutable std::mutex                  m_mutex;
+    std::array<pool, num_section_kinds> m_pools;
+    llvm::sys::MemoryBlock              m_last_slab;
+  };
+
+  // One is created for each object. All of the sections of a kind are carved out of a single
+  // range when RuntimeDyld reserves space up front, so each kind needs just one permission
+  // change at finalization.
+  class llvm_memory_manager
+    : public llvm::RTDyldMemoryManager
+  {
+  public:
+    llvm_memory_manager            (void)                           = delete;
+    llvm_memory_manager            (const llvm_memory_manager&)     = delete;
+    llvm_memory_manager            (llvm_memory_manager&&) noexcept = delete;
+    llvm_memory_manager& operator= (const llvm_memory_manager&)     = delete;
+    llvm_memory_manager& operator= (llvm_memory_manager&&) noexcept = delete;
+    ~llvm_memory_manager           (void) override;
+
+    explicit
+    llvm_memory_manager (llvm_slab_allocator& allocator);
+
+    bool
+    needsToReserveAllocationSpace (void) override;
+
+    void
+    reserveAllocationSpace (std::uintptr_t code_size,   std::uint32_t code_align,
+                            std::uintptr_t rodata_size, std::uint32_t rodata_align,
+                            std::uintptr_t rwdata_size, std::uint32_t rwdata_align) override;
+
+    std::uint8_t *
+    allocateCodeSection (std::uintptr_t size, unsigned alignment, unsigned section_id,
+                         llvm::StringRef section_name) override;
+
+    std::uint8_t *
+    allocateDataSection (std::uintptr_t size, unsigned alignment, unsigned section_id,
+                         llvm::StringRef section_name, bool is_read_only) override;
+
+    bool
+    finalizeMemory (std::string *err_msg) override;
+
+  private:
+    using section_kind = llvm_slab_allocator::section_kind;
+
+    struct arena
+    {
+      std::vector<llvm_slab_allocator::range> ranges;
+      std::uintptr_t                          cursor = 0;
+      std::uintptr_t                          end    = 0;
+      std::size_t                             used   = 0;
+    };
+
+    std::uint8_t *
+    allocate_section (section_kind kind, std::uintptr_t size, unsigned alignment);
+
+    bool
+    reserve (section_kind kind, std::uintptr_t size);
+
+    // Returns the pages at the end of the arena which no section occupies.
+    void
+    trim (section_kind kind);
+
+    [[nodiscard]]
+    arena&
+    get_arena (section_kind kind) noexcept;
+
+    llvm_slab_allocator&                                      m_allocator;
+    std::array<arena, llvm_slab_allocator::num_section_kinds> m_arenas;
+  };
+
+}
+
+#endif // OCTAVE_IR_COMPILER_LLVM_LLVM_MEMORY_MANAGER_HPP
@@ -0,0 +1,110 @@
+/** llvm-object-cache.hpp
+ * An on-disk cache of object files emitted for static functions.
+ *
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef OCTAVE_IR_COMPILER_LLVM_LLVM_OBJECT_CACHE_HPP
+#define OCTAVE_IR_COMPILER_LLVM_LLVM_OBJECT_CACHE_HPP
+
+#include "llvm-common.hpp"
+
+#include <gch/nonnull_ptr.hpp>
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace llvm
+{
+
+  class Module;
+
+}
+
+namespace gch
+{
+
+  class ir_static_function;
+  class llvm_runtime_library;
+
+  class llvm_object_cache
+    : public llvm::ObjectCache
+  {
+  public:
+    llvm_object_cache            (void)                         = default;
+    llvm_object_cache            (const llvm_object_cache&)     = delete;
+    llvm_object_cache            (llvm_object_cache&&) noexcept = delete;
+    llvm_object_cache& operator= (const llvm_object_cache&)     = delete;
+    llvm_object_cache& operator= (llvm_object_cache&&) noexcept = delete;
+    ~llvm_object_cache           (void) override;
+
+    void
+    enable (std::string_view directory, std::size_t max_size);
+
+    void
+    disable (void);
+
+    [[nodiscard]]
+    bool
+    is_enabled (void) const;
+
+    // The configuration id should uniquely describe everything besides the static functions and
+    // the runtime library which affects the emitted object (the target triple, CPU features, and
+    // optimization settings).
+    [[nodiscard]]
+    static
+    std::string
+    get_key (const ir_static_function& func, std::string_view configuration_id,
+             const llvm_runtime_library& runtime_library);
+
+    [[nodiscard]]
+    static
+    std::string
+    get_key (const std::vector<nonnull_ptr<const ir_static_function>>& funcs,
+             std::string_view configuration_id, const llvm_runtime_library& runtime_library);
+
+    [[nodiscard]]
+    std::unique_ptr<llvm::MemoryBuffer>
+    find (std::string_view key);
+
+    void
+    notifyObjectCompiled (const llvm::Module *module, llvm::MemoryBufferRef obj) override;
+
+    // Lookups are performed by the AST layer before translation, so there is nothing to be
+    // gained by checking again right before instruction selection.
+    std::unique_ptr<llvm::MemoryBuffer>
+    getObject (const llvm::Module *module) override;
+
+  private:
+    [[nodiscard]]
+    std::string
+    get_path (std::string_view key) const;
+
+    void
+    store (std::string_view key, llvm::MemoryBufferRef obj);
+
+    void
+    enforce_size_limit (void);
+
+    mutable std::mutex m_mutex;
+    std::string        m_directory;
+    std::size_t        m_max_size = 0;
+  };
+
+}
+
+#endif // OCTAVE_IR_COMPILER_LLVM_LLVM_OBJECT_CACHE_HPP
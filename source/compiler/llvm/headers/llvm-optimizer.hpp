@@ -0,0 +1,146 @@
+/** llvm-optimizer.hpp
+ * The IR optimization pipeline and the IR compiler which honors its optimization level.
+ *
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef OCTAVE_IR_COMPILER_LLVM_LLVM_OPTIMIZER_HPP
+#define OCTAVE_IR_COMPILER_LLVM_LLVM_OPTIMIZER_HPP
+
+#include "llvm-common.hpp"
+
+#include "gch/octave-ir-compiler-interface.hpp"
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/ExecutionEngine/Orc/Core.h>
+#include <llvm/ExecutionEngine/Orc/IRCompileLayer.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace gch
+{
+
+  // Optimization settings may be changed while modules are being optimized and compiled on
+  // other threads. Each module is compiled with a single snapshot of the settings, so that the
+  // pipeline, the target machine, and the cache key always agree.
+  class llvm_optimizer
+  {
+  public:
+    struct settings
+    {
+      llvm::orc::JITTargetMachineBuilder jit_builder;
+      octave_jit_optimization_level      level;
+      std::string                        custom_pipeline;
+      octave_jit_vector_library          vector_library = octave_jit_vector_library::none;
+
+      // Uniquely describes the settings, for use as a cache key.
+      std::string                        configuration_id;
+    };
+
+    using settings_ptr = std::shared_ptr<const settings>;
+
+    class compiler
+      : public llvm::orc::IRCompileLayer::IRCompiler
+    {
+    public:
+      compiler (const llvm_optimizer& optimizer, llvm::ObjectCache *object_cache);
+
+      llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>>
+      operator() (llvm::Module& module) override;
+
+    private:
+      const llvm_optimizer&  m_optimizer;
+      llvm::ObjectCache     *m_object_cache;
+    };
+
+    llvm_optimizer            (void)                      = delete;
+    llvm_optimizer            (const llvm_optimizer&)     = delete;
+    llvm_optimizer            (llvm_optimizer&&) noexcept = delete;
+    llvm_optimizer& operator= (const llvm_optimizer&)     = delete;
+    llvm_optimizer& operator= (llvm_optimizer&&) noexcept = delete;
+    ~llvm_optimizer           (void)                      = default;
+
+    explicit
+    llvm_optimizer (llvm::orc::JITTargetMachineBuilder jit_builder,
+                    octave_jit_optimization_level level = octave_jit_optimization_level::O2);
+
+    void
+    set_level (octave_jit_optimization_level level);
+
+    [[nodiscard]]
+    octave_jit_optimization_level
+    get_level (void) const;
+
+    // Throws `ir_exception` if the pipeline cannot be parsed.
+    void
+    append_passes (std::string_view pipeline);
+
+    void
+    clear_passes (void);
+
+    // An empty `cpu` selects the host CPU along with all of its features. Otherwise `features`
+    // (such as "+avx2,-avx512f") adjusts the defaults of `cpu`. Throws `ir_exception` if the
+    // CPU is not recognized for the target.
+    void
+    set_target (std::string_view cpu, std::string_view features);
+
+    // Throws `ir_exception` if the library is not available for the target.
+    void
+    set_vector_library (octave_jit_vector_library lib);
+
+    [[nodiscard]]
+    std::string
+    get_configuration_id (void) const;
+
+    // The snapshot is unaffected by later changes to the settings.
+    [[nodiscard]]
+    settings_ptr
+    get_settings (void) const;
+
+    [[nodiscard]]
+    std::unique_ptr<compiler>
+    create_compiler (llvm::ObjectCache *object_cache) const;
+
+    llvm::Expected<llvm::orc::ThreadSafeModule>
+    operator() (llvm::orc::ThreadSafeModule module,
+                const llvm::orc::MaterializationResponsibility& resp) const;
+
+    // Runs the pipeline for the current settings, outside of any layer.
+    llvm::Error
+    optimize (llvm::orc::ThreadSafeModule& module) const;
+
+    static
+    llvm::Error
+    optimize (llvm::orc::ThreadSafeModule& module, const settings& s);
+
+    // Generates an object for `module`, which should already be optimized with `s`. The object
+    // is passed to `object_cache`, if it is not null.
+    static
+    llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>>
+    compile (llvm::Module& module, const settings& s, llvm::ObjectCache *object_cache);
+
+  private:
+    // Replaces the settings with a modified copy. `f` is called with the mutex held.
+    template <typename Function>
+    void
+    update_settings (Function f);
+
+    mutable std::mutex m_mutex;
+    settings_ptr       m_settings;
+  };
+
+}
+
+#endif // OCTAVE_IR_COMPILER_LLVM_LLVM_OPTIMIZER_HPP
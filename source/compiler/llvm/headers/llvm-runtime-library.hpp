@@ -0,0 +1,53 @@
+/** llvm-runtime-library.hpp
+ * Host functions which compiled code calls by name.
+ *
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef OCTAVE_IR_COMPILER_LLVM_LLVM_RUNTIME_LIBRARY_HPP
+#define OCTAVE_IR_COMPILER_LLVM_LLVM_RUNTIME_LIBRARY_HPP
+
+#include "llvm-common.hpp"
+
+#include "gch/octave-ir-compiler-interface.hpp"
+
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace gch
+{
+
+  // The symbols themselves are defined in the main dylib. This only holds the signatures and
+  // attributes, for declaring the functions in the modules which call them.
+  class llvm_runtime_library
+  {
+  public:
+    // Functions are never removed, so the pointers returned by `find` remain valid.
+    void
+    add (octave_jit_runtime_function func);
+
+    // Returns nullptr if no function with the name has been registered.
+    [[nodiscard]]
+    const octave_jit_runtime_function *
+    find (std::string_view name) const;
+
+    // Describes the signature and attributes which calls to the function are declared with, for
+    // use in cache keys. Returns an empty string if no function with the name has been
+    // registered.
+    [[nodiscard]]
+    std::string
+    get_declaration_id (std::string_view name) const;
+
+  private:
+    mutable std::mutex                                           m_mutex;
+    std::unordered_map<std::string, octave_jit_runtime_function> m_functions;
+  };
+
+}
+
+#endif // OCTAVE_IR_COMPILER_LLVM_LLVM_RUNTIME_LIBRARY_HPP
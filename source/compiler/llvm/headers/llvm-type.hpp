@@ -54,9 +54,10 @@ inline constexpr llvm::Type::TypeID GCH_LONG_DOUBLE_LLVM_TYPE_ID = llvm::Type::D
 #  error Unrecognized long double.
 #endif
 
+class octave_base_value;
+
 namespace gch
 {
-  class octave_base_value;
   class ir_block;
   class ir_block_id;
   class ir_external_function_info;
@@ -10,6 +10,7 @@
 
 #include "llvm-common.hpp"
 #include "llvm-type.hpp"
+#include "ir-external-function-info.hpp"
 #include "ir-type-util.hpp"
 
 #include <gch/nonnull_ptr.hpp>
@@ -32,9 +33,9 @@ GCH_ENABLE_WARNINGS_MSVC
 namespace llvm
 {
 
-  class AllocaInst;
   class BasicBlock;
   class ConstantInt;
+  class DIBuilder;
   class Function;
   class LLVMContext;
   class NoFolder;
@@ -56,26 +57,43 @@ namespace gch
   class ir_static_operand;
   class ir_static_use;
   class ir_static_variable;
+  class llvm_runtime_library;
+
+  struct octave_jit_runtime_function;
+
+  // Works on both declarations and call sites.
+  template <typename FunctionOrCall>
+  void
+  add_llvm_attributes (FunctionOrCall& target,
+                       const ir_external_function_info::attributes& attrs)
+  {
+    if (attrs.read_none)
+      target.setDoesNotAccessMemory ();
+    else if (attrs.read_only)
+      target.setOnlyReadsMemory ();
+
+    if (attrs.no_unwind)
+      target.setDoesNotThrow ();
+    if (attrs.will_return)
+      target.addFnAttr (llvm::Attribute::WillReturn);
+    if (attrs.no_free)
+      target.addFnAttr (llvm::Attribute::NoFree);
+  }
 
   class llvm_def_map
   {
   public:
     explicit
-    llvm_def_map (llvm::AllocaInst& alloc, std::size_t num_defs);
+    llvm_def_map (std::size_t num_defs);
 
     llvm::Value&
     register_def (ir_def_id id, llvm::Value& llvm_value);
 
-    [[nodiscard]]
-    llvm::AllocaInst&
-    get_allocation (void) const noexcept;
-
     [[nodiscard]]
     llvm::Value&
     operator[] (ir_def_id id) const;
 
   private:
-    nonnull_ptr<llvm::AllocaInst>          m_llvm_alloc;
     std::vector<optional_ref<llvm::Value>> m_llvm_defs;
   };
 
@@ -84,7 +102,9 @@ namespace gch
   public:
     using llvm_module_type = llvm::orc::ThreadSafeModule;
 
-    llvm_module_interface (llvm_module_type& llvm_module);
+    llvm_module_interface (llvm_module_type& llvm_module,
+                           llvm::DIBuilder *debug_builder = nullptr,
+                           const llvm_runtime_library *runtime_library = nullptr);
 
     [[nodiscard]]
     llvm::Type&
@@ -113,8 +133,35 @@ namespace gch
     llvm::ConstantInt&
     get_bool_constant (bool b);
 
+    // The attributes are added when the function is first declared in the module. A function in
+    // the runtime library is declared with its registered signature and attributes instead, so
+    // that the linker binds it to the registered address. Throws `ir_exception` if the function
+    // has already been declared with a different signature.
+    optional_ref<llvm::Function>
+    get_external_function (std::string_view name, llvm::FunctionType& prototype,
+                           const ir_external_function_info::attributes& attrs = { });
+
+    // Returns the intrinsic for a known math function (see `find_math_intrinsic`), or nothing
+    // if there is none. Functions in the runtime library are always called as registered.
     optional_ref<llvm::Function>
-    get_external_function (std::string_view name, llvm::FunctionType& prototype);
+    get_math_intrinsic (std::string_view name, llvm::FunctionType& prototype);
+
+    // Throws `std::logic_error` if the prototype at the call site does not match the signature
+    // with which the function was registered.
+    llvm::Function&
+    get_runtime_function (const octave_jit_runtime_function& runtime_func,
+                          llvm::FunctionType& prototype);
+
+    // Returns the function compiled from the static function `name`. If it is translated into
+    // this module then calls bind to it directly (and it may be inlined). Otherwise it is
+    // declared, and the linker binds calls to it within the JIT.
+    llvm::Function&
+    get_jit_function (std::string_view name, llvm::FunctionType& prototype);
+
+    // Returns nullptr if debug info is not being emitted.
+    [[nodiscard]]
+    llvm::DIBuilder *
+    get_debug_builder (void) const noexcept;
 
     template <typename Functor, typename ...Args>
     decltype (auto)
@@ -182,6 +229,8 @@ namespace gch
     ir_type_map<llvm::Type *>      m_type_map;
     nonnull_ptr<llvm::ConstantInt> m_true_value;
     nonnull_ptr<llvm::ConstantInt> m_false_value;
+    llvm::DIBuilder               *m_debug_builder;
+    const llvm_runtime_library    *m_runtime_library;
   };
 
   class llvm_value_map
@@ -207,12 +256,6 @@ namespace gch
     llvm::BasicBlock&
     operator[] (const ir_static_block& block) const;
 
-    llvm::AllocaInst&
-    operator[] (const ir_static_variable& var) const;
-
-    llvm::AllocaInst&
-    operator[] (ir_static_def def) const;
-
     llvm::Value&
     operator[] (ir_static_use use);
 
@@ -9,32 +9,250 @@
 #define OCTAVE_IR_OCTAVE_IR_COMPILER_LLVM_HPP
 
 #include "gch/octave-ir-compiler-interface.hpp"
+#include "ir-static-fingerprint.hpp"
 
+#include <cstddef>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace gch
 {
 
+  class llvm_compile_queue;
   class llvm_interface;
 
+  enum class llvm_entry_kind;
+
+  // Which linker places emitted objects in memory. The default is chosen when the library is
+  // built (see `GCH_OCTAVE_IR_USE_JITLINK`). Memory statistics are only collected for `rtdyld`.
+  enum class octave_jit_llvm_linker
+  {
+    rtdyld,
+    jitlink,
+  };
+
   class octave_jit_compiler_llvm : public octave_jit_compiler_impl
   {
   public:
     octave_jit_compiler_llvm            (void);
     octave_jit_compiler_llvm            (const octave_jit_compiler_llvm&)     = delete;
-    octave_jit_compiler_llvm            (octave_jit_compiler_llvm&&) noexcept = default;
+    octave_jit_compiler_llvm            (octave_jit_compiler_llvm&&) noexcept = delete;
     octave_jit_compiler_llvm& operator= (const octave_jit_compiler_llvm&)     = delete;
-    octave_jit_compiler_llvm& operator= (octave_jit_compiler_llvm&&) noexcept = default;
+    octave_jit_compiler_llvm& operator= (octave_jit_compiler_llvm&&) noexcept = delete;
     ~octave_jit_compiler_llvm           (void) override;
 
+    explicit
+    octave_jit_compiler_llvm (octave_jit_llvm_linker linker);
+
+    // `num_async_workers` threads service `compile_async`, which blocks once
+    // `async_queue_capacity` jobs are waiting.
+    octave_jit_compiler_llvm (std::size_t num_async_workers, std::size_t async_queue_capacity);
+
+    octave_jit_compiler_llvm (std::size_t num_async_workers, std::size_t async_queue_capacity,
+                              octave_jit_llvm_linker linker);
+
+    [[nodiscard]]
+    static
+    octave_jit_llvm_linker
+    get_default_linker (void) noexcept;
+
     void *
     compile (const ir_static_function& func) override;
 
+    std::vector<void *>
+    compile_batch (const function_refs& funcs) override;
+
+    void *
+    compile_map (const ir_static_function& func) override;
+
+    void *
+    compile_boxed (const ir_static_function& func) override;
+
+    void *
+    compile_lazy (ir_static_function&& func) override;
+
+    octave_jit_compile_handle
+    compile_async (ir_static_function&& func, int priority) override;
+
+    bool
+    release (std::string_view name) override;
+
+    void *
+    replace (ir_static_function&& func) override;
+
+    void *
+    publish (ir_static_function&& func) override;
+
+    bool
+    redirect (std::string_view name, std::size_t generation) override;
+
+    [[nodiscard]]
+    void *
+    find (std::string_view name) const override;
+
+    void
+    register_runtime_function (octave_jit_runtime_function func) override;
+
+    void
+    emit_object (const function_refs& funcs, std::string_view path) override;
+
+    std::vector<octave_jit_aot_function>
+    load_object (std::string_view path) override;
+
+    [[nodiscard]]
+    octave_jit_memory_stats
+    get_memory_stats (void) const override;
+
+    void
+    enable_statistics (bool enable) override;
+
+    void
+    reset_statistics (void) override;
+
+    [[nodiscard]]
+    octave_jit_compile_stats
+    get_statistics (void) const override;
+
+    [[nodiscard]]
+    std::string
+    get_chrome_trace (void) const override;
+
     void
     enable_printing (bool printing = true) override;
 
+    void
+    set_optimization_level (octave_jit_optimization_level level) override;
+
+    void
+    append_passes (std::string_view pipeline) override;
+
+    void
+    clear_passes (void) override;
+
+    void
+    set_target_cpu (std::string_view cpu, std::string_view features) override;
+
+    void
+    set_vector_library (octave_jit_vector_library lib) override;
+
+    void
+    enable_object_cache (std::string_view directory, std::size_t max_size) override;
+
+    void
+    disable_object_cache (void) override;
+
+    void
+    enable_jit_registration (void) override;
+
+    void
+    enable_debug_info (bool enable) override;
+
+    [[nodiscard]]
+    std::optional<octave_jit_source_location>
+    find_source_location (const void *address) const override;
+
   private:
+    // The code emitted by a single call to the JIT, which is freed all at once when the last name
+    // referring to it is released.
+    struct compiled_unit;
+
+    struct compiled_function
+    {
+      std::shared_future<void *>     address;
+      std::shared_ptr<compiled_unit> unit;
+      std::string                    symbol;  // The name under which it was first compiled.
+    };
+
+    struct named_function
+    {
+      std::shared_ptr<compiled_unit> unit;
+      void                          *address;
+    };
+
+    // The entry point for the versions of a published function.
+    struct published_function
+    {
+      void        *stub;
+      std::size_t  num_generations;
+      std::size_t  current;
+    };
+
+    void *
+    find_or_compile (std::string_view name, const ir_static_fingerprint& fp,
+                     const std::function<void * (compiled_unit&)>& compile_new);
+
+    // Compiles a wrapper around the function, which is deduplicated and released separately
+    // from the scalar entry point.
+    void *
+    compile_entry (const ir_static_function& func, llvm_entry_kind kind);
+
+    // Throws if a call with `jit` linkage names a function which is neither among `funcs` nor
+    // compiled already. The process would otherwise be searched for a host function with the
+    // same name.
+    void
+    check_jit_callees (const function_refs& funcs) const;
+
+    // Defines `name` as an alias of `symbol` if they differ. Returns false if the unit was
+    // released while the caller waited on it, and throws if the name is taken.
+    bool
+    register_name (std::string_view name, const std::shared_ptr<compiled_unit>& unit,
+                   void *address, std::string_view symbol);
+
+    // Like `register_name`, but the mutex must be held.
+    bool
+    insert_name (std::string_view name, const std::shared_ptr<compiled_unit>& unit,
+                 void *address, std::string_view symbol);
+
+    // Erases the name. Its alias, along with the code if no other name refers to it, is moved to
+    // `garbage` so that it may be removed once the mutex is released. The mutex must be held.
+    void
+    release_name (std::unordered_map<std::string, named_function>::iterator it,
+                  compiled_unit& garbage);
+
+    // Throws if new code cannot be defined under the name. The mutex must be held.
+    void
+    check_symbol_available (std::string_view name) const;
+
+    // Whether the name is the version a published entry point refers to. The mutex must be held.
+    [[nodiscard]]
+    bool
+    is_current_version (std::string_view name) const;
+
+    // Erases the fingerprints, names, and symbols which refer to the unit. The mutex must be held.
+    void
+    unregister_unit (const std::shared_ptr<compiled_unit>& unit);
+
+    // Removes the code and aliases of the unit from the JIT.
+    void
+    remove_unit (compiled_unit& unit);
+
     std::unique_ptr<llvm_interface> m_interface;
+
+    // Structurally identical functions share the entry point of whichever was compiled first.
+    // Entries are inserted before compilation starts so that concurrent requests for the same
+    // function wait on the first rather than defining the symbol twice.
+    mutable std::mutex                                           m_compiled_mutex;
+    std::unordered_map<ir_static_fingerprint, compiled_function> m_compiled;
+    std::unordered_map<std::string, named_function>              m_named_units;
+    std::unordered_map<std::string, published_function>          m_published;
+    std::size_t                                                  m_num_replacements = 0;
+
+    // Symbols which are still defined by code in use, but which no name refers to. A released
+    // function whose code is shared keeps its symbol until the code is freed.
+    std::unordered_set<std::string>                              m_orphaned_symbols;
+
+    std::size_t                         m_num_async_workers;
+    std::size_t                         m_async_queue_capacity;
+    std::once_flag                      m_compile_queue_flag;
+    std::unique_ptr<llvm_compile_queue> m_compile_queue;
   };
 
 }
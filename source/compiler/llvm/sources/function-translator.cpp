@@ -18,22 +18,77 @@
 
 #include <gch/nonnull_ptr.hpp>
 
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/IR/DIBuilder.h>
+#include <llvm/IR/DebugInfoMetadata.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
 #include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 namespace gch
 {
 
+  // Gives `llvm_func` a subprogram in a file named after `func`, so that code inlined into the
+  // wrappers is still attributed to the static function. Returns nullptr if debug info is not
+  // being emitted.
+  static
+  llvm::DISubprogram *
+  create_subprogram (const ir_static_function& func, llvm::Function& llvm_func,
+                     llvm_module_interface& module_interface)
+  {
+    llvm::DIBuilder *debug_builder = module_interface.get_debug_builder ();
+    if (! debug_builder)
+      return nullptr;
+
+    std::string_view name = func.get_name ();
+    llvm::DIFile *file = debug_builder->createFile (llvm::StringRef (name.data (), name.size ()),
+                                                    "");
+
+    llvm::DISubprogram *subprogram = debug_builder->createFunction (
+      file,
+      llvm_func.getName (),
+      llvm::StringRef (),
+      file,
+      1,
+      debug_builder->createSubroutineType (debug_builder->getOrCreateTypeArray ({ })),
+      1,
+      llvm::DINode::FlagZero,
+      llvm::DISubprogram::SPFlagDefinition);
+
+    llvm_func.setSubprogram (subprogram);
+    return subprogram;
+  }
+
   static
   llvm::BasicBlock&
-  translate_block (const ir_static_block& block, llvm_value_map& value_map)
+  translate_block (const ir_static_block& block, std::size_t block_index,
+                   llvm_value_map& value_map, llvm::DISubprogram *subprogram)
   {
     constexpr auto instruction_map = ir_metadata::generate_map<instruction_translator_mapper> ();
 
     llvm::BasicBlock& llvm_block = value_map[block];
     llvm_ir_builder_type block_builder (&llvm_block);
 
+    std::size_t instr_index = 0;
     std::for_each (block.begin (), block.end (), [&](const ir_static_instruction& instr) {
+      // The line is the index of the block and the column is the index of the instruction,
+      // both counting from one. Line zero is left for code which has no instruction.
+      if (subprogram)
+      {
+        block_builder.SetCurrentDebugLocation (
+          llvm::DILocation::get (subprogram->getContext (),
+                                 static_cast<unsigned> (block_index + 1),
+                                 static_cast<unsigned> (instr_index + 1),
+                                 subprogram));
+      }
+      ++instr_index;
+
       try
       {
         llvm::Value *val = instruction_map[instr.get_metadata ()] (instr, block_builder, value_map);
@@ -50,12 +105,24 @@ namespace gch
     return llvm_block;
   }
 
+  // Errors raised by external functions (such as `throw_error`) are thrown as C++ exceptions,
+  // so every emitted function needs an unwind table for them to propagate to the caller. This
+  // costs nothing on the normal path.
   static
-  llvm::Function&
-  translate_function (const ir_static_function& func, llvm::orc::ThreadSafeModule& llvm_tsm)
+  void
+  enable_unwinding (llvm::Function& func)
   {
-    llvm_module_interface module_interface (llvm_tsm);
+#if GCH_LLVM_VERSION_MAJOR_LESS (15)
+    func.addFnAttr (llvm::Attribute::UWTable);
+#else
+    func.setUWTableKind (llvm::UWTableKind::Default);
+#endif
+  }
 
+  static
+  llvm::Function&
+  translate_function (const ir_static_function& func, llvm_module_interface& module_interface)
+  {
     llvm::SmallVector<llvm::Type *> arg_types;
     std::transform (func.args_begin (), func.args_end (), std::back_inserter (arg_types),
                     [&] (const ir_variable_id& id) {
@@ -68,17 +135,32 @@ namespace gch
     llvm::FunctionType *llvm_function_ty = llvm::FunctionType::get (&ret_type, arg_types, false);
 
     llvm::Function& out_func = *module_interface.invoke_with_module ([&](llvm::Module& module) {
+      // A function earlier in the batch which calls this one will have declared it already.
+      std::string_view name = func.get_name ();
+      if (llvm::Function *decl = module.getFunction (llvm::StringRef (name.data (), name.size ())))
+      {
+        if (decl->isDeclaration () && decl->getFunctionType () == llvm_function_ty)
+          return decl;
+
+        throw std::logic_error ("The function `" + std::string (name)
+                                + "` is called with a different signature than it has.");
+      }
+
       return llvm::Function::Create (
         llvm_function_ty,
         llvm::Function::ExternalLinkage,
-        create_twine (func.get_name ()),
+        create_twine (name),
         module);
     });
 
+    enable_unwinding (out_func);
+    llvm::DISubprogram *subprogram = create_subprogram (func, out_func, module_interface);
+
     llvm_value_map value_map { module_interface, out_func, func };
 
+    std::size_t block_index = 0;
     std::for_each (func.begin (), func.end (), [&](const ir_static_block& block) {
-      translate_block (block, value_map);
+      translate_block (block, block_index++, value_map, subprogram);
     });
 
     // resolve the phi nodes
@@ -119,14 +201,202 @@ namespace gch
     return out_func;
   }
 
+  // Creates `void name.map (const A1 *a1, ..., const An *an, R *out, size_t n)`, which computes
+  // `out[i] = name (a1[i], ..., an[i])` for each `i < n`. The scalar function is inlined into
+  // the loop so that the loop may be vectorized.
+  static
+  llvm::Function&
+  translate_map_function (const ir_static_function& func, llvm::Function& scalar_func,
+                          llvm_module_interface& module_interface)
+  {
+    scalar_func.setLinkage (llvm::Function::InternalLinkage);
+    scalar_func.addFnAttr (llvm::Attribute::AlwaysInline);
+
+    llvm::FunctionType& scalar_ty  = *scalar_func.getFunctionType ();
+    llvm::Type&         result_ty  = *scalar_ty.getReturnType ();
+    bool                has_result = ! result_ty.isVoidTy ();
+
+    return *module_interface.invoke_with_module ([&](llvm::Module& module) {
+      llvm::LLVMContext& context = module.getContext ();
+      llvm::IntegerType& size_ty = *module.getDataLayout ().getIntPtrType (context);
+
+      llvm::SmallVector<llvm::Type *> param_types;
+      std::transform (scalar_ty.param_begin (), scalar_ty.param_end (),
+                      std::back_inserter (param_types),
+                      [](llvm::Type *ty) { return ty->getPointerTo (); });
+      if (has_result)
+        param_types.push_back (result_ty.getPointerTo ());
+      param_types.push_back (&size_ty);
+
+      llvm::Function& map_func = *llvm::Function::Create (
+        llvm::FunctionType::get (llvm::Type::getVoidTy (context), param_types, false),
+        llvm::Function::ExternalLinkage,
+        create_twine (get_entry_name (func.get_name (), llvm_entry_kind::map)),
+        module);
+      enable_unwinding (map_func);
+
+      // The arrays may not overlap, so the vectorizer needs no runtime alias checks.
+      unsigned num_args   = scalar_ty.getNumParams ();
+      unsigned num_arrays = static_cast<unsigned> (param_types.size ()) - 1;
+      for (unsigned i = 0; i < num_arrays; ++i)
+      {
+        map_func.addParamAttr (i, llvm::Attribute::NoAlias);
+        map_func.addParamAttr (i, llvm::Attribute::NoCapture);
+        if (i < num_args)
+          map_func.addParamAttr (i, llvm::Attribute::ReadOnly);
+      }
+
+      llvm::BasicBlock& entry_block = *llvm::BasicBlock::Create (context, "entry", &map_func);
+      llvm::BasicBlock& loop_block  = *llvm::BasicBlock::Create (context, "loop", &map_func);
+      llvm::BasicBlock& after_block = *llvm::BasicBlock::Create (context, "after", &map_func);
+
+      llvm::Argument&    count = *map_func.getArg (num_arrays);
+      llvm::ConstantInt& zero  = *llvm::ConstantInt::get (&size_ty, 0);
+      llvm::ConstantInt& one   = *llvm::ConstantInt::get (&size_ty, 1);
+
+      llvm_ir_builder_type builder (&entry_block);
+      if (llvm::DISubprogram *subprogram = create_subprogram (func, map_func, module_interface))
+        builder.SetCurrentDebugLocation (llvm::DILocation::get (context, 0, 0, subprogram));
+
+      builder.CreateCondBr (builder.CreateICmpEQ (&count, &zero), &after_block, &loop_block);
+
+      builder.SetInsertPoint (&loop_block);
+      llvm::PHINode& index = *builder.CreatePHI (&size_ty, 2, "i");
+
+      llvm::SmallVector<llvm::Value *> args;
+      for (unsigned i = 0; i < num_args; ++i)
+      {
+        llvm::Type&  arg_ty  = *scalar_ty.getParamType (i);
+        llvm::Value& arg_ptr = *builder.CreateInBoundsGEP (&arg_ty, map_func.getArg (i), &index);
+        args.push_back (builder.CreateLoad (&arg_ty, &arg_ptr));
+      }
+
+      llvm::Value& result = *builder.CreateCall (&scalar_func, args);
+      if (has_result)
+      {
+        llvm::Value& out_ptr = *builder.CreateInBoundsGEP (&result_ty, map_func.getArg (num_args),
+                                                           &index);
+        builder.CreateStore (&result, &out_ptr);
+      }
+
+      llvm::Value& next = *builder.CreateNUWAdd (&index, &one, "i.next");
+      builder.CreateCondBr (builder.CreateICmpEQ (&next, &count), &after_block, &loop_block);
+
+      index.addIncoming (&zero, &entry_block);
+      index.addIncoming (&next, &loop_block);
+
+      builder.SetInsertPoint (&after_block);
+      builder.CreateRetVoid ();
+
+      return &map_func;
+    });
+  }
+
+  // Creates `void name.boxed (void **args, void *ret)`, which loads each argument through the
+  // corresponding pointer in `args`, and stores the result (if any) through `ret`. Callers
+  // which only know the types at runtime can then call any function in the same way.
+  static
+  llvm::Function&
+  translate_boxed_function (const ir_static_function& func, llvm::Function& scalar_func,
+                            llvm_module_interface& module_interface)
+  {
+    scalar_func.setLinkage (llvm::Function::InternalLinkage);
+    scalar_func.addFnAttr (llvm::Attribute::AlwaysInline);
+
+    llvm::FunctionType& scalar_ty = *scalar_func.getFunctionType ();
+    llvm::Type&         result_ty = *scalar_ty.getReturnType ();
+
+    return *module_interface.invoke_with_module ([&](llvm::Module& module) {
+      llvm::LLVMContext& context = module.getContext ();
+      llvm::PointerType& ptr_ty  = *llvm::Type::getInt8PtrTy (context);
+
+      llvm::Function& boxed_func = *llvm::Function::Create (
+        llvm::FunctionType::get (llvm::Type::getVoidTy (context),
+                                 { ptr_ty.getPointerTo (), &ptr_ty },
+                                 false),
+        llvm::Function::ExternalLinkage,
+        create_twine (get_entry_name (func.get_name (), llvm_entry_kind::boxed)),
+        module);
+      enable_unwinding (boxed_func);
+
+      boxed_func.addParamAttr (0, llvm::Attribute::NoCapture);
+      boxed_func.addParamAttr (0, llvm::Attribute::ReadOnly);
+      boxed_func.addParamAttr (1, llvm::Attribute::NoCapture);
+
+      llvm::BasicBlock& entry_block = *llvm::BasicBlock::Create (context, "entry", &boxed_func);
+      llvm_ir_builder_type builder (&entry_block);
+      if (llvm::DISubprogram *subprogram = create_subprogram (func, boxed_func, module_interface))
+        builder.SetCurrentDebugLocation (llvm::DILocation::get (context, 0, 0, subprogram));
+
+      llvm::SmallVector<llvm::Value *> args;
+      for (unsigned i = 0; i < scalar_ty.getNumParams (); ++i)
+      {
+        llvm::Type&  arg_ty   = *scalar_ty.getParamType (i);
+        llvm::Value& slot_ptr = *builder.CreateConstInBoundsGEP1_32 (&ptr_ty,
+                                                                     boxed_func.getArg (0), i);
+        llvm::Value& arg_ptr  = *builder.CreateLoad (&ptr_ty, &slot_ptr);
+        llvm::Value& typed    = *builder.CreateBitCast (&arg_ptr, arg_ty.getPointerTo ());
+        args.push_back (builder.CreateLoad (&arg_ty, &typed));
+      }
+
+      llvm::Value& result = *builder.CreateCall (&scalar_func, args);
+      if (! result_ty.isVoidTy ())
+      {
+        llvm::Value& typed = *builder.CreateBitCast (boxed_func.getArg (1),
+                                                     result_ty.getPointerTo ());
+        builder.CreateStore (&result, &typed);
+      }
+
+      builder.CreateRetVoid ();
+      return &boxed_func;
+    });
+  }
+
   llvm::orc::ThreadSafeModule
-  create_llvm_module (const llvm::DataLayout& data_layout, const ir_static_function& func)
+  create_llvm_module (const llvm::DataLayout& data_layout,
+                      const std::vector<nonnull_ptr<const ir_static_function>>& funcs,
+                      llvm_entry_kind kind, bool debug_info,
+                      const llvm_runtime_library *runtime_library)
   {
     auto llvm_context = std::make_unique<llvm::LLVMContext> ();
     auto llvm_module  = std::make_unique<llvm::Module> ("my jit", *llvm_context);
     llvm_module->setDataLayout (data_layout);
+
+    std::optional<llvm::DIBuilder> debug_builder;
+    if (debug_info)
+    {
+      llvm_module->addModuleFlag (llvm::Module::Warning, "Debug Info Version",
+                                  llvm::DEBUG_METADATA_VERSION);
+      debug_builder.emplace (*llvm_module);
+      debug_builder->createCompileUnit (llvm::dwarf::DW_LANG_C,
+                                        debug_builder->createFile ("octave-ir", ""),
+                                        "octave-ir", true, "", 0);
+    }
+
     llvm::orc::ThreadSafeModule llvm_tsm (std::move (llvm_module), std::move (llvm_context));
-    translate_function (func, llvm_tsm);
+
+    // The functions share a single context, so types, constants, and external declarations are
+    // only created once for the whole batch.
+    llvm_module_interface module_interface (llvm_tsm, debug_builder ? &*debug_builder : nullptr,
+                                            runtime_library);
+    std::for_each (funcs.begin (), funcs.end (), [&](nonnull_ptr<const ir_static_function> func) {
+      llvm::Function& llvm_func = translate_function (*func, module_interface);
+      switch (kind)
+      {
+        case llvm_entry_kind::scalar:
+          break;
+        case llvm_entry_kind::map:
+          translate_map_function (*func, llvm_func, module_interface);
+          break;
+        case llvm_entry_kind::boxed:
+          translate_boxed_function (*func, llvm_func, module_interface);
+          break;
+      }
+    });
+
+    if (debug_builder)
+      debug_builder->finalize ();
+
     return llvm_tsm;
   }
 
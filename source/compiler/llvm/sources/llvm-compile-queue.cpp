@@ -0,0 +1,117 @@
+/** llvm-compile-queue.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "llvm-compile-queue.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace gch
+{
+
+  llvm_compile_queue::
+  llvm_compile_queue (compile_function compile, std::size_t num_workers, std::size_t capacity)
+    : m_compile  (std::move (compile)),
+      m_capacity (std::max (capacity, std::size_t { 1 }))
+  {
+    m_jobs.reserve (m_capacity);
+
+    num_workers = std::max (num_workers, std::size_t { 1 });
+    m_workers.reserve (num_workers);
+    for (std::size_t i = 0; i < num_workers; ++i)
+      m_workers.emplace_back ([this] { run_worker (); });
+  }
+
+  llvm_compile_queue::
+  ~llvm_compile_queue (void)
+  {
+    {
+      std::scoped_lock lock (m_mutex);
+      m_stopping = true;
+
+      // Jobs which have not started will never be run.
+      for (job& j : m_jobs)
+        j.state->cancel ();
+      m_jobs.clear ();
+    }
+
+    m_not_empty.notify_all ();
+    m_not_full.notify_all ();
+
+    for (std::thread& worker : m_workers)
+      worker.join ();
+  }
+
+  octave_jit_compile_handle
+  llvm_compile_queue::
+  submit (ir_static_function&& func, int priority)
+  {
+    auto state = std::make_shared<octave_jit_compile_state> ();
+
+    {
+      std::unique_lock lock (m_mutex);
+      m_not_full.wait (lock, [&] { return m_stopping || m_jobs.size () < m_capacity; });
+
+      if (m_stopping)
+      {
+        state->cancel ();
+        return octave_jit_compile_handle { std::move (state) };
+      }
+
+      m_jobs.push_back ({ priority, m_next_sequence++, std::move (func), state });
+      std::push_heap (m_jobs.begin (), m_jobs.end (), compare_jobs);
+    }
+
+    m_not_empty.notify_one ();
+    return octave_jit_compile_handle { std::move (state) };
+  }
+
+  bool
+  llvm_compile_queue::
+  compare_jobs (const job& lhs, const job& rhs) noexcept
+  {
+    // The heap is a max-heap, so among jobs of equal priority the earliest must compare greatest.
+    if (lhs.priority != rhs.priority)
+      return lhs.priority < rhs.priority;
+    return lhs.sequence > rhs.sequence;
+  }
+
+  void
+  llvm_compile_queue::
+  run_worker (void)
+  {
+    while (true)
+    {
+      std::unique_lock lock (m_mutex);
+      m_not_empty.wait (lock, [&] { return m_stopping || ! m_jobs.empty (); });
+
+      if (m_stopping)
+        return;
+
+      std::pop_heap (m_jobs.begin (), m_jobs.end (), compare_jobs);
+      job j = std::move (m_jobs.back ());
+      m_jobs.pop_back ();
+
+      lock.unlock ();
+      m_not_full.notify_one ();
+
+      if (! j.state->try_start ())
+        continue;
+
+      try
+      {
+        j.state->set_result (m_compile (j.function));
+      }
+      catch (...)
+      {
+        j.state->set_exception (std::current_exception ());
+      }
+    }
+  }
+
+}
@@ -0,0 +1,253 @@
+/** llvm-compile-stats.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "llvm-compile-stats.hpp"
+
+#include "ir-error.hpp"
+#include "ir-static-block.hpp"
+#include "ir-static-function.hpp"
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Support/Error.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+
+namespace gch
+{
+
+  static thread_local llvm_compile_stats::module_scope *current_scope = nullptr;
+
+  static
+  const char *
+  get_phase_name (octave_jit_compile_phase phase)
+  {
+    switch (phase)
+    {
+      case octave_jit_compile_phase::translate: return "translate";
+      case octave_jit_compile_phase::optimize:  return "optimize";
+      case octave_jit_compile_phase::codegen:   return "codegen";
+      case octave_jit_compile_phase::link:      return "link";
+    }
+    abort<reason::impossible> ();
+  }
+
+  static
+  void
+  add_phase (octave_jit_phase_stats_array& phases, octave_jit_compile_phase phase,
+             std::chrono::nanoseconds time)
+  {
+    octave_jit_phase_stats& p = phases[static_cast<std::size_t> (phase)];
+    ++p.count;
+    p.time += time;
+  }
+
+  static
+  void
+  append_json_string (std::string& out, std::string_view str)
+  {
+    out.push_back ('"');
+    std::for_each (str.begin (), str.end (), [&](char c) {
+      switch (c)
+      {
+        case '"':  out.append ("\\\""); break;
+        case '\\': out.append ("\\\\"); break;
+        case '\n': out.append ("\\n");  break;
+        default:
+          if (static_cast<unsigned char> (c) < 0x20)
+          {
+            char buf[8];
+            std::snprintf (buf, sizeof (buf), "\\u%04x", static_cast<unsigned> (c));
+            out.append (buf);
+          }
+          else
+            out.push_back (c);
+      }
+    });
+    out.push_back ('"');
+  }
+
+  //
+  // llvm_compile_stats::module_scope
+  //
+
+  llvm_compile_stats::module_scope::
+  module_scope (llvm_compile_stats& stats, const function_refs& funcs)
+    : m_stats (stats),
+      m_outer (current_scope)
+  {
+    std::for_each (funcs.begin (), funcs.end (), [&](nonnull_ptr<const ir_static_function> f) {
+      m_record.functions.emplace_back (f->get_name ());
+      m_record.num_blocks += f->num_blocks ();
+      std::for_each (f->begin (), f->end (), [&](const ir_static_block& block) {
+        m_record.num_instructions += block.size ();
+      });
+    });
+    current_scope = this;
+  }
+
+  llvm_compile_stats::module_scope::
+  ~module_scope (void)
+  {
+    current_scope = m_outer;
+    m_stats.commit (*this);
+  }
+
+  void
+  llvm_compile_stats::module_scope::
+  set_cached (void) noexcept
+  {
+    m_record.cached = true;
+  }
+
+  //
+  // llvm_compile_stats
+  //
+
+  llvm_compile_stats::
+  llvm_compile_stats (void)
+    : m_epoch (clock::now ())
+  { }
+
+  void
+  llvm_compile_stats::
+  enable (bool enable) noexcept
+  {
+    m_enabled.store (enable, std::memory_order_relaxed);
+  }
+
+  bool
+  llvm_compile_stats::
+  is_enabled (void) const noexcept
+  {
+    return m_enabled.load (std::memory_order_relaxed);
+  }
+
+  void
+  llvm_compile_stats::
+  reset (void)
+  {
+    std::scoped_lock lock (m_mutex);
+    m_epoch = clock::now ();
+    m_stats = { };
+    m_events.clear ();
+  }
+
+  octave_jit_compile_stats
+  llvm_compile_stats::
+  get (void) const
+  {
+    std::scoped_lock lock (m_mutex);
+    return m_stats;
+  }
+
+  std::string
+  llvm_compile_stats::
+  get_chrome_trace (void) const
+  {
+    using microseconds = std::chrono::duration<double, std::micro>;
+
+    std::scoped_lock lock (m_mutex);
+
+    // Threads are numbered in order of appearance so that the trace is readable.
+    std::unordered_map<std::thread::id, std::size_t> thread_ids;
+
+    std::string out = "[";
+    std::for_each (m_events.begin (), m_events.end (), [&](const trace_event& e) {
+      if (out.size () > 1)
+        out.append (",");
+
+      std::size_t tid = thread_ids.try_emplace (e.thread, thread_ids.size ()).first->second;
+
+      const octave_jit_module_stats& mod = m_stats.modules[e.module];
+      std::string functions;
+      std::for_each (mod.functions.begin (), mod.functions.end (), [&](const std::string& f) {
+        if (! functions.empty ())
+          functions.append (",");
+        functions.append (f);
+      });
+
+      out.append ("\n{\"name\":");
+      append_json_string (out, get_phase_name (e.phase));
+      out.append (",\"cat\":\"octave-ir\",\"ph\":\"X\",\"pid\":0,\"tid\":");
+      out.append (std::to_string (tid));
+      out.append (",\"ts\":");
+      out.append (std::to_string (microseconds (e.start - m_epoch).count ()));
+      out.append (",\"dur\":");
+      out.append (std::to_string (microseconds (e.end - e.start).count ()));
+      out.append (",\"args\":{\"functions\":");
+      append_json_string (out, functions);
+      out.append (",\"cached\":");
+      out.append (mod.cached ? "true" : "false");
+      out.append ("}}");
+    });
+    out.append ("\n]\n");
+    return out;
+  }
+
+  bool
+  llvm_compile_stats::
+  is_active (void) noexcept
+  {
+    return current_scope != nullptr;
+  }
+
+  void
+  llvm_compile_stats::
+  record (octave_jit_compile_phase phase, clock::time_point start, clock::time_point end)
+  {
+    if (! current_scope)
+      return;
+
+    add_phase (current_scope->m_record.phases, phase, end - start);
+    current_scope->m_events.push_back ({ phase, start, end });
+  }
+
+  void
+  llvm_compile_stats::
+  record_code (const llvm::MemoryBuffer& obj)
+  {
+    if (! current_scope)
+      return;
+
+    auto obj_file = llvm::object::ObjectFile::createObjectFile (obj.getMemBufferRef ());
+    if (! obj_file)
+    {
+      llvm::consumeError (obj_file.takeError ());
+      return;
+    }
+
+    for (const llvm::object::SectionRef& section : (*obj_file)->sections ())
+    {
+      if (section.isText ())
+        current_scope->m_record.code_size += section.getSize ();
+    }
+  }
+
+  void
+  llvm_compile_stats::
+  commit (module_scope& scope)
+  {
+    std::scoped_lock lock (m_mutex);
+
+    std::size_t module = m_stats.modules.size ();
+    std::thread::id thread = std::this_thread::get_id ();
+    std::for_each (scope.m_events.begin (), scope.m_events.end (),
+                   [&](const module_scope::event& e) {
+      add_phase (m_stats.phases, e.phase, e.end - e.start);
+      m_events.push_back ({ e.phase, module, e.start, e.end, thread });
+    });
+
+    m_stats.modules.push_back (std::move (scope.m_record));
+  }
+
+}
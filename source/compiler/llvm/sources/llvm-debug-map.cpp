@@ -0,0 +1,160 @@
+/** llvm-debug-map.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "llvm-debug-map.hpp"
+
+#include "ir-static-block.hpp"
+#include "ir-static-function.hpp"
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/DebugInfo/DWARF/DWARFContext.h>
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Object/SymbolSize.h>
+#include <llvm/Support/Error.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace gch
+{
+
+  void
+  llvm_debug_map::
+  add_function (const ir_static_function& func)
+  {
+    std::vector<std::string> names;
+    names.reserve (func.num_blocks ());
+    std::transform (func.begin (), func.end (), std::back_inserter (names),
+                    [](const ir_static_block& block) { return std::string (block.get_name ()); });
+
+    std::scoped_lock lock (m_mutex);
+    m_block_names[std::string (func.get_name ())] = std::move (names);
+  }
+
+  std::optional<octave_jit_source_location>
+  llvm_debug_map::
+  find (std::uint64_t address) const
+  {
+    std::scoped_lock lock (m_mutex);
+
+    auto range_it = m_ranges.upper_bound (address);
+    if (range_it == m_ranges.begin ())
+      return std::nullopt;
+
+    const code_range& range = std::prev (range_it)->second;
+    if (range.end <= address)
+      return std::nullopt;
+
+    // The row which covers the address is the last one which starts at or before it.
+    auto row_it = std::upper_bound (range.rows.begin (), range.rows.end (), address,
+                                    [](std::uint64_t addr, const row& r) {
+                                      return addr < r.address;
+                                    });
+    if (row_it == range.rows.begin ())
+      return std::nullopt;
+
+    const row& r = *std::prev (row_it);
+    if (r.line == 0 || r.column == 0)
+      return std::nullopt;
+
+    octave_jit_source_location loc;
+    loc.function          = range.files[r.file];
+    loc.block_index       = r.line - 1;
+    loc.instruction_index = r.column - 1;
+
+    auto names_it = m_block_names.find (loc.function);
+    if (names_it != m_block_names.end () && loc.block_index < names_it->second.size ())
+      loc.block_name = names_it->second[loc.block_index];
+
+    return loc;
+  }
+
+  void
+  llvm_debug_map::
+  notifyObjectLoaded (ObjectKey key, const llvm::object::ObjectFile& obj,
+                      const llvm::RuntimeDyld::LoadedObjectInfo& info)
+  {
+    // The debug object has its sections relocated to where they were loaded.
+    llvm::object::OwningBinary<llvm::object::ObjectFile> debug_obj = info.getObjectForDebug (obj);
+    if (! debug_obj.getBinary ())
+      return;
+
+    std::unique_ptr<llvm::DWARFContext> context =
+      llvm::DWARFContext::create (*debug_obj.getBinary ());
+
+    llvm::DILineInfoSpecifier spec (
+      llvm::DILineInfoSpecifier::FileLineInfoKind::RawValue,
+      llvm::DILineInfoSpecifier::FunctionNameKind::None);
+
+    std::vector<std::pair<std::uint64_t, code_range>> ranges;
+    for (const auto& [sym, size] : llvm::object::computeSymbolSizes (*debug_obj.getBinary ()))
+    {
+      llvm::Expected<llvm::object::SymbolRef::Type> type = sym.getType ();
+      if (! type)
+      {
+        llvm::consumeError (type.takeError ());
+        continue;
+      }
+
+      if (*type != llvm::object::SymbolRef::ST_Function || size == 0)
+        continue;
+
+      llvm::Expected<std::uint64_t>                  address = sym.getAddress ();
+      llvm::Expected<llvm::object::section_iterator> section = sym.getSection ();
+      if (! address || ! section)
+      {
+        llvm::consumeError (address.takeError ());
+        llvm::consumeError (section.takeError ());
+        continue;
+      }
+
+      code_range range { *address + size, key, { }, { } };
+      llvm::DILineInfoTable lines = context->getLineInfoForAddressRange (
+        { *address, (*section)->getIndex () }, size, spec);
+
+      for (const auto& [line_address, line_info] : lines)
+      {
+        auto file_it = std::find (range.files.begin (), range.files.end (), line_info.FileName);
+        if (file_it == range.files.end ())
+          file_it = range.files.insert (range.files.end (), line_info.FileName);
+
+        range.rows.push_back ({
+          line_address,
+          static_cast<std::size_t> (std::distance (range.files.begin (), file_it)),
+          line_info.Line,
+          line_info.Column
+        });
+      }
+
+      if (! range.rows.empty ())
+        ranges.emplace_back (*address, std::move (range));
+    }
+
+    std::scoped_lock lock (m_mutex);
+    for (auto& [address, range] : ranges)
+      m_ranges.insert_or_assign (address, std::move (range));
+  }
+
+  void
+  llvm_debug_map::
+  notifyFreeingObject (ObjectKey key)
+  {
+    std::scoped_lock lock (m_mutex);
+    for (auto it = m_ranges.begin (); it != m_ranges.end (); )
+    {
+      if (it->second.key == key)
+        it = m_ranges.erase (it);
+      else
+        ++it;
+    }
+  }
+
+}
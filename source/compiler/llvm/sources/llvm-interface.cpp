@@ -6,24 +6,63 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include "llvm-interface.hpp"
+#include "ir-error.hpp"
 #include "ir-static-function.hpp"
 
-#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/ExecutionEngine/JITEventListener.h>
+#include <llvm/ExecutionEngine/JITLink/EHFrameSupport.h>
+#include <llvm/ExecutionEngine/Orc/DebugObjectManagerPlugin.h>
+#include <llvm/ExecutionEngine/Orc/EPCDebugObjectRegistrar.h>
+#include <llvm/ExecutionEngine/Orc/TargetProcess/JITLoaderGDB.h>
+#include <llvm/ExecutionEngine/Orc/TaskDispatch.h>
 #include <llvm/Support/TargetSelect.h>
-#include <llvm/Transforms/InstCombine/InstCombine.h>
-#include <llvm/Transforms/Scalar/GVN.h>
-#include <llvm/Transforms/Scalar.h>
 
+#include <algorithm>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <utility>
 
 namespace gch
 {
 
+  // Referencing the GDB registration entry point keeps it linked into this library, where
+  // `createJITLoaderGDBRegistrar` looks for it among the symbols of the process.
+  static void *volatile jit_loader_gdb_wrapper =
+    reinterpret_cast<void *> (&llvm_orc_registerJITLoaderGDBWrapper);
+
+  std::string
+  get_entry_name (std::string_view name, llvm_entry_kind kind)
+  {
+    switch (kind)
+    {
+      case llvm_entry_kind::scalar: return std::string (name);
+      case llvm_entry_kind::map:    return std::string (name) + ".map";
+      case llvm_entry_kind::boxed:  return std::string (name) + ".boxed";
+    }
+    abort<reason::impossible> ();
+  }
+
   llvm_interface::ast_layer::materialization_unit::
-  materialization_unit (ast_layer& ast_layer, const ir_static_function& func)
-    : MaterializationUnit (ast_layer.get_interface (func), nullptr),
+  materialization_unit (ast_layer& ast_layer, function_refs funcs, llvm_entry_kind kind)
+    : MaterializationUnit (ast_layer.get_interface (funcs, kind), nullptr),
       m_ast_layer (ast_layer),
-      m_function (func)
+      m_functions (std::move (funcs)),
+      m_kind      (kind)
+  { }
+
+  llvm_interface::ast_layer::materialization_unit::
+  materialization_unit (ast_layer& ast_layer, std::unique_ptr<ir_static_function> func)
+    : MaterializationUnit (ast_layer.get_interface ({ nonnull_ptr { std::as_const (*func) } },
+                                                    llvm_entry_kind::scalar),
+                           nullptr),
+      m_ast_layer      (ast_layer),
+      m_owned_function (std::move (func)),
+      m_functions      ({ nonnull_ptr { std::as_const (*m_owned_function) } }),
+      m_kind           (llvm_entry_kind::scalar)
   { }
 
   llvm::StringRef
@@ -37,7 +76,7 @@ namespace gch
   llvm_interface::ast_layer::materialization_unit::
   materialize (std::unique_ptr<llvm::orc::MaterializationResponsibility> resp)
   {
-    m_ast_layer.emit (std::move (resp), m_function);
+    m_ast_layer.emit (std::move (resp), m_functions, m_kind);
   }
 
   void
@@ -48,43 +87,146 @@ namespace gch
   }
 
   llvm_interface::ast_layer::
-  ast_layer (llvm::orc::IRLayer& base_layer, const llvm::DataLayout& data_layout, bool printing)
-    : m_base_layer (base_layer),
-      m_data_layout (data_layout),
+  ast_layer (const llvm_optimizer& optimizer, llvm::orc::ObjectLayer& object_layer,
+             llvm_object_cache& object_cache, llvm_compile_stats& compile_stats,
+             const llvm_runtime_library& runtime_library,
+             const llvm::DataLayout& data_layout, bool printing)
+    : m_optimizer        (optimizer),
+      m_object_layer     (object_layer),
+      m_object_cache     (object_cache),
+      m_compile_stats    (compile_stats),
+      m_runtime_library  (runtime_library),
+      m_data_layout      (data_layout),
       m_printing_enabled (printing)
   { }
 
   llvm::Error
   llvm_interface::ast_layer::
-  add (const ir_static_function& func, llvm::orc::ResourceTrackerSP res_tracker)
+  add (function_refs funcs, llvm::orc::ResourceTrackerSP res_tracker, llvm_entry_kind kind)
+  {
+    return res_tracker->getJITDylib ().define (
+      std::make_unique<materialization_unit> (*this, std::move (funcs), kind),
+      res_tracker);
+  }
+
+  llvm::Error
+  llvm_interface::ast_layer::
+  add (std::unique_ptr<ir_static_function> func, llvm::orc::ResourceTrackerSP res_tracker)
   {
     return res_tracker->getJITDylib ().define (
-      std::make_unique<materialization_unit> (*this, func),
+      std::make_unique<materialization_unit> (*this, std::move (func)),
       res_tracker);
   }
 
   void
   llvm_interface::ast_layer::
   emit (std::unique_ptr<llvm::orc::MaterializationResponsibility> resp,
-        const ir_static_function& func)
+        const function_refs& funcs, llvm_entry_kind kind)
   {
-    llvm::orc::ThreadSafeModule tsm = create_llvm_module (m_data_layout, func);
+    using clock = llvm_compile_stats::clock;
+
+    // Phases deeper in the pipeline record themselves into the scope.
+    std::optional<llvm_compile_stats::module_scope> stats_scope;
+    if (m_compile_stats.is_enabled ())
+      stats_scope.emplace (m_compile_stats, funcs);
+
+    bool            debug_info = m_debug_info_enabled.load ();
+    llvm_debug_map *debug_map  = m_debug_map.load ();
+    if (debug_info && debug_map)
+    {
+      std::for_each (funcs.begin (), funcs.end (), [&](nonnull_ptr<const ir_static_function> f) {
+        debug_map->add_function (*f);
+      });
+    }
+
+    // This may run on a dispatcher thread, so errors must not escape. The lookup which triggered
+    // materialization fails instead.
+    auto fail = [&](llvm::Error err) {
+      m_object_layer.getExecutionSession ().reportError (std::move (err));
+      resp->failMaterialization ();
+    };
+
+    auto link = [&](std::unique_ptr<llvm::MemoryBuffer> obj) {
+      clock::time_point start = stats_scope ? clock::now () : clock::time_point { };
+      m_object_layer.emit (std::move (resp), std::move (obj));
+      if (stats_scope)
+        llvm_compile_stats::record (octave_jit_compile_phase::link, start, clock::now ());
+    };
+
+    // The settings may change while we are emitting. A single snapshot is used for the cache key,
+    // the pipeline, and codegen, so that the cached object always matches its key.
+    llvm_optimizer::settings_ptr settings = m_optimizer.get_settings ();
+
+    std::string cache_key;
+    if (m_object_cache.is_enabled ())
+    {
+      // On a hit we skip translation, optimization, and instruction selection entirely.
+      cache_key = get_entry_name (llvm_object_cache::get_key (funcs, settings->configuration_id,
+                                                              m_runtime_library),
+                                  kind);
+      if (debug_info)
+        cache_key.append (".debug");
+
+      if (std::unique_ptr<llvm::MemoryBuffer> obj = m_object_cache.find (cache_key))
+      {
+        if (stats_scope)
+        {
+          stats_scope->set_cached ();
+          llvm_compile_stats::record_code (*obj);
+        }
+        return link (std::move (obj));
+      }
+    }
+
+    clock::time_point translate_start = stats_scope ? clock::now () : clock::time_point { };
+    llvm::orc::ThreadSafeModule tsm;
+    try
+    {
+      tsm = create_llvm_module (m_data_layout, funcs, kind, debug_info, &m_runtime_library);
+    }
+    catch (const std::exception& e)
+    {
+      return fail (llvm::createStringError (llvm::inconvertibleErrorCode (), e.what ()));
+    }
+    if (stats_scope)
+    {
+      llvm_compile_stats::record (octave_jit_compile_phase::translate, translate_start,
+                                  clock::now ());
+    }
+
+    // The compiler populates the cache from the module identifier after codegen.
+    if (! cache_key.empty ())
+      tsm.withModuleDo ([&](llvm::Module& module) { module.setModuleIdentifier (cache_key); });
+
     if (m_printing_enabled)
     {
+      std::scoped_lock lock (m_print_mutex);
       tsm.withModuleDo ([&](llvm::Module& module) { module.print (llvm::outs (), nullptr); });
       std::cout << std::endl;
     }
-    m_base_layer.emit (std::move (resp), std::move (tsm));
+
+    if (llvm::Error err = llvm_optimizer::optimize (tsm, *settings))
+      return fail (std::move (err));
+
+    auto obj = tsm.withModuleDo ([&](llvm::Module& module) {
+      return llvm_optimizer::compile (module, *settings, &m_object_cache);
+    });
+    if (! obj)
+      return fail (obj.takeError ());
+
+    link (std::move (*obj));
   }
 
   llvm::orc::SymbolFlagsMap
   llvm_interface::ast_layer::
-  get_interface (const ir_static_function& func)
+  get_interface (const function_refs& funcs, llvm_entry_kind kind)
   {
-    llvm::orc::MangleAndInterner mangler (m_base_layer.getExecutionSession (), m_data_layout);
+    llvm::orc::MangleAndInterner mangler (m_object_layer.getExecutionSession (), m_data_layout);
     llvm::orc::SymbolFlagsMap syms;
-    syms[mangler (func.get_name ().data ())] =
-      llvm::JITSymbolFlags (llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable);
+    std::for_each (funcs.begin (), funcs.end (), [&](nonnull_ptr<const ir_static_function> func) {
+      syms[mangler (get_entry_name (func->get_name (), kind))] =
+        llvm::JITSymbolFlags (llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable);
+    });
     return syms;
   }
 
@@ -95,26 +237,46 @@ namespace gch
     m_printing_enabled = printing;
   }
 
+  void
+  llvm_interface::ast_layer::
+  enable_debug_info (bool debug_info, llvm_debug_map *debug_map)
+  {
+    // The map is published first, so that emission never sees debug info enabled without it.
+    m_debug_map          = debug_map;
+    m_debug_info_enabled = debug_info;
+  }
+
   llvm_interface::
   llvm_interface (std::unique_ptr<llvm::orc::ExecutionSession> execution_session,
                   std::unique_ptr<llvm::orc::EPCIndirectionUtils> epc_indirection_utils,
                   llvm::orc::JITTargetMachineBuilder&& jit_builder,
-                  const llvm::DataLayout& data_layout)
-    : m_execution_session     (std::move (execution_session)),
-      m_epc_indirection_utils (std::move (epc_indirection_utils)),
-      m_data_layout           (data_layout),
-      m_mangler               (*m_execution_session, m_data_layout),
-      m_object_layer          (*m_execution_session, create_memory_manager),
-      m_compile_layer         (*m_execution_session, m_object_layer,
-                               create_compiler (std::move (jit_builder))),
-      m_optimization_layer    (*m_execution_session, m_compile_layer, optimize_module),
-      m_ast_layer             (m_optimization_layer, m_data_layout),
-      m_jit_dylib             (m_execution_session->createBareJITDylib ("<main>"))
+                  const llvm::DataLayout& data_layout,
+                  octave_jit_llvm_linker linker)
+    : m_execution_session      (std::move (execution_session)),
+      m_epc_indirection_utils  (std::move (epc_indirection_utils)),
+      m_indirect_stubs_manager (m_epc_indirection_utils->createIndirectStubsManager ()),
+      m_redirect_stubs_manager (m_epc_indirection_utils->createIndirectStubsManager ()),
+      m_data_layout            (data_layout),
+      m_mangler                (*m_execution_session, m_data_layout),
+      m_optimizer              (std::move (jit_builder)),
+      m_linker                 (linker),
+      m_object_layer           (create_object_layer (linker)),
+      m_compile_layer          (*m_execution_session, *m_object_layer,
+                                m_optimizer.create_compiler (&m_object_cache)),
+      m_optimization_layer     (*m_execution_session, m_compile_layer, std::cref (m_optimizer)),
+      m_ast_layer              (m_optimizer, *m_object_layer, m_object_cache,
+                                m_compile_stats, m_runtime_library, m_data_layout),
+      m_jit_dylib              (m_execution_session->createBareJITDylib ("<main>")),
+      m_lazy_jit_dylib         (m_execution_session->createBareJITDylib ("<lazy>"))
   {
     m_jit_dylib.addGenerator (llvm::cantFail (
       llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess (
         m_data_layout.getGlobalPrefix ()))
     );
+
+    // External functions referenced by lazily compiled functions are resolved from the
+    // main dylib (and hence from the process).
+    m_lazy_jit_dylib.addToLinkOrder (m_jit_dylib);
   }
 
   llvm_interface::
@@ -154,11 +316,172 @@ namespace gch
   llvm::Error
   llvm_interface::
   add_ast (const ir_static_function& func, llvm::orc::ResourceTrackerSP res_tracker)
+  {
+    return add_ast ({ nonnull_ptr { func } }, std::move (res_tracker));
+  }
+
+  llvm::Error
+  llvm_interface::
+  add_ast (function_refs funcs, llvm::orc::ResourceTrackerSP res_tracker)
   {
     if (! res_tracker)
       res_tracker = m_jit_dylib.getDefaultResourceTracker ();
 
-    return m_ast_layer.add (func, res_tracker);
+    return m_ast_layer.add (std::move (funcs), res_tracker);
+  }
+
+  llvm::Error
+  llvm_interface::
+  add_entry_ast (const ir_static_function& func, llvm_entry_kind kind,
+                 llvm::orc::ResourceTrackerSP res_tracker)
+  {
+    if (! res_tracker)
+      res_tracker = m_jit_dylib.getDefaultResourceTracker ();
+
+    return m_ast_layer.add ({ nonnull_ptr { func } }, res_tracker, kind);
+  }
+
+  llvm::Error
+  llvm_interface::
+  add_lazy_ast (ir_static_function&& func,
+                llvm::orc::ResourceTrackerSP stub_tracker,
+                llvm::orc::ResourceTrackerSP body_tracker)
+  {
+    if (! stub_tracker)
+      stub_tracker = m_jit_dylib.getDefaultResourceTracker ();
+
+    if (! body_tracker)
+      body_tracker = m_lazy_jit_dylib.getDefaultResourceTracker ();
+
+    // The definition lives in the lazy dylib, and the main dylib gets a stub which looks it up
+    // (and thus materializes it) on its first call.
+    llvm::orc::SymbolStringPtr name = m_mangler (func.get_name ().data ());
+
+    llvm::orc::SymbolAliasMap aliases;
+    aliases[name] = llvm::orc::SymbolAliasMapEntry (
+      name,
+      llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable);
+
+    if (llvm::Error err = m_ast_layer.add (std::make_unique<ir_static_function> (std::move (func)),
+                                           std::move (body_tracker)))
+    {
+      return err;
+    }
+
+    return m_jit_dylib.define (llvm::orc::lazyReexports (
+      m_epc_indirection_utils->getLazyCallThroughManager (),
+      *m_indirect_stubs_manager,
+      m_lazy_jit_dylib,
+      std::move (aliases)),
+      std::move (stub_tracker));
+  }
+
+  llvm::orc::ResourceTrackerSP
+  llvm_interface::
+  create_resource_tracker (void)
+  {
+    return m_jit_dylib.createResourceTracker ();
+  }
+
+  llvm::orc::ResourceTrackerSP
+  llvm_interface::
+  create_lazy_resource_tracker (void)
+  {
+    return m_lazy_jit_dylib.createResourceTracker ();
+  }
+
+  llvm::Error
+  llvm_interface::
+  remove (llvm::orc::ResourceTrackerSP res_tracker)
+  {
+    // The object layer frees the memory manager which owns the sections of each object.
+    return res_tracker->remove ();
+  }
+
+  llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>>
+  llvm_interface::
+  compile_object (const function_refs& funcs, std::string& configuration_id)
+  {
+    llvm_optimizer::settings_ptr settings = m_optimizer.get_settings ();
+    configuration_id = settings->configuration_id;
+    llvm::orc::ThreadSafeModule tsm = create_llvm_module (m_data_layout, funcs,
+                                                          llvm_entry_kind::scalar, false,
+                                                          &m_runtime_library);
+    if (llvm::Error err = llvm_optimizer::optimize (tsm, *settings))
+      return std::move (err);
+
+    return tsm.withModuleDo ([&](llvm::Module& module) {
+      return llvm_optimizer::compile (module, *settings, nullptr);
+    });
+  }
+
+  llvm::Error
+  llvm_interface::
+  add_object (std::unique_ptr<llvm::MemoryBuffer> obj, llvm::orc::ResourceTrackerSP res_tracker)
+  {
+    return m_object_layer->add (std::move (res_tracker), std::move (obj));
+  }
+
+  llvm::Error
+  llvm_interface::
+  add_alias (std::string_view alias, std::string_view target,
+             llvm::orc::ResourceTrackerSP res_tracker)
+  {
+    llvm::orc::SymbolAliasMap aliases;
+    aliases[m_mangler (llvm::StringRef (alias.data (), alias.size ()))] =
+      llvm::orc::SymbolAliasMapEntry (
+        m_mangler (llvm::StringRef (target.data (), target.size ())),
+        llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable);
+
+    return m_jit_dylib.define (llvm::orc::symbolAliases (std::move (aliases)),
+                               std::move (res_tracker));
+  }
+
+  llvm::Expected<std::uint64_t>
+  llvm_interface::
+  create_redirect (std::string_view name, std::uint64_t target)
+  {
+    // Redirects have their own stubs manager so that their names cannot clash with the stubs of
+    // lazily compiled functions.
+    llvm::JITSymbolFlags flags = llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable;
+    llvm::StringRef      stub_name (name.data (), name.size ());
+    if (llvm::Error err = m_redirect_stubs_manager->createStub (stub_name, target, flags))
+      return std::move (err);
+
+    llvm::JITEvaluatedSymbol stub = m_redirect_stubs_manager->findStub (stub_name, true);
+    if (llvm::Error err = m_jit_dylib.define (
+          llvm::orc::absoluteSymbols ({ { m_mangler (stub_name), stub } })))
+    {
+      return std::move (err);
+    }
+    return stub.getAddress ();
+  }
+
+  llvm::Error
+  llvm_interface::
+  update_redirect (std::string_view name, std::uint64_t target)
+  {
+    return m_redirect_stubs_manager->updatePointer (llvm::StringRef (name.data (), name.size ()),
+                                                    target);
+  }
+
+  llvm::Error
+  llvm_interface::
+  add_runtime_function (octave_jit_runtime_function func)
+  {
+    llvm::JITEvaluatedSymbol sym (
+      static_cast<llvm::JITTargetAddress> (reinterpret_cast<std::uintptr_t> (func.address)),
+      llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable);
+
+    if (llvm::Error err = m_jit_dylib.define (
+          llvm::orc::absoluteSymbols ({ { m_mangler (func.name), sym } })))
+    {
+      return std::move (err);
+    }
+
+    // Modules only declare the function once its symbol exists.
+    m_runtime_library.add (std::move (func));
+    return llvm::Error::success ();
   }
 
   llvm::Expected<llvm::JITEvaluatedSymbol>
@@ -168,15 +491,56 @@ namespace gch
     return m_execution_session->lookup ({ &get_jit_dylib () }, m_mangler (name.data ()));
   }
 
+  llvm::Expected<std::vector<llvm::JITEvaluatedSymbol>>
+  llvm_interface::
+  find_symbols (const std::vector<std::string_view>& names)
+  {
+    std::vector<llvm::orc::SymbolStringPtr> mangled;
+    mangled.reserve (names.size ());
+    std::transform (names.begin (), names.end (), std::back_inserter (mangled),
+                    [&](std::string_view name) { return m_mangler (name.data ()); });
+
+    llvm::orc::SymbolLookupSet lookup_set;
+    std::for_each (mangled.begin (), mangled.end (), [&](const llvm::orc::SymbolStringPtr& sym) {
+      lookup_set.add (sym);
+    });
+
+    auto found = m_execution_session->lookup (
+      llvm::orc::makeJITDylibSearchOrder (&get_jit_dylib ()),
+      std::move (lookup_set));
+
+    if (! found)
+      return found.takeError ();
+
+    std::vector<llvm::JITEvaluatedSymbol> ret;
+    ret.reserve (mangled.size ());
+    std::transform (mangled.begin (), mangled.end (), std::back_inserter (ret),
+                    [&](const llvm::orc::SymbolStringPtr& sym) { return (*found)[sym]; });
+    return ret;
+  }
+
   llvm::Expected<std::unique_ptr<llvm_interface>>
   llvm_interface::
-  create (void)
+  create (octave_jit_llvm_linker linker)
   {
-    llvm::InitializeNativeTarget();
-    llvm::InitializeNativeTargetAsmPrinter();
-    llvm::InitializeNativeTargetAsmParser();
+    // The target registry is global and not synchronized.
+    static std::once_flag target_flag;
+    std::call_once (target_flag, [] {
+      llvm::InitializeNativeTarget();
+      llvm::InitializeNativeTargetAsmPrinter();
+      llvm::InitializeNativeTargetAsmParser();
+    });
 
-    auto executor_process_control = llvm::orc::SelfExecutorProcessControl::Create ();
+#if LLVM_ENABLE_THREADS
+    // Materializations are dispatched to a thread pool so that the concurrent compiler actually
+    // runs concurrently.
+    auto dispatcher = std::make_unique<llvm::orc::DynamicThreadPoolTaskDispatcher> ();
+#else
+    auto dispatcher = std::make_unique<llvm::orc::InPlaceTaskDispatcher> ();
+#endif
+
+    auto executor_process_control = llvm::orc::SelfExecutorProcessControl::Create (
+      nullptr, std::move (dispatcher));
     if (! executor_process_control)
       return executor_process_control.takeError ();
 
@@ -209,63 +573,211 @@ namespace gch
       std::move (execution_session),
       std::move (*epc_indirection_utils),
       std::move (jit_builder),
-      *data_layout);
+      *data_layout,
+      linker);
 
     return interface;
   }
 
-  std::unique_ptr<llvm::SectionMemoryManager>
+  auto
+  llvm_interface::
+  create_object_layer (octave_jit_llvm_linker linker)
+    -> std::unique_ptr<object_layer_type>
+  {
+    if (linker == octave_jit_llvm_linker::jitlink)
+    {
+      // JITLink links in place in memory from the executor's memory manager, and supports the
+      // small code model without stubs for nearby symbols.
+      auto layer = std::make_unique<llvm::orc::ObjectLinkingLayer> (
+        *m_execution_session,
+        m_execution_session->getExecutorProcessControl ().getMemMgr ());
+
+      layer->addPlugin (std::make_unique<llvm::orc::EHFrameRegistrationPlugin> (
+        *m_execution_session,
+        std::make_unique<llvm::jitlink::InProcessEHFrameRegistrar> ()));
+
+      return layer;
+    }
+
+    return std::make_unique<llvm::orc::RTDyldObjectLinkingLayer> (
+      *m_execution_session,
+      [this] { return create_memory_manager (); });
+  }
+
+  std::unique_ptr<llvm_memory_manager>
   llvm_interface::
   create_memory_manager (void)
   {
-    return std::make_unique<llvm::SectionMemoryManager> ();
+    return std::make_unique<llvm_memory_manager> (m_slab_allocator);
   }
 
-  std::unique_ptr<llvm::orc::ConcurrentIRCompiler>
+  void
   llvm_interface::
-  create_compiler (llvm::orc::JITTargetMachineBuilder&& jit_builder)
+  handle_lazy_call_through_error (void)
   {
-    return std::make_unique<llvm::orc::ConcurrentIRCompiler> (std::move (jit_builder));
+    throw std::runtime_error ("Missing LLVM function body.");
   }
 
-  llvm::Expected<llvm::orc::ThreadSafeModule>
+  void
   llvm_interface::
-  optimize_module (llvm::orc::ThreadSafeModule module,
-                   const llvm::orc::MaterializationResponsibility&)
+  enable_printing (bool printing)
   {
-    module.withModuleDo ([](llvm::Module& mod) {
-      // Create a function pass manager.
-      llvm::legacy::FunctionPassManager function_pass_manager (&mod);
+    m_ast_layer.enable_printing (printing);
+  }
 
-      // Add some optimizations.
-      function_pass_manager.add (llvm::createInstructionCombiningPass ());
-      function_pass_manager.add (llvm::createReassociatePass ());
-      function_pass_manager.add (llvm::createGVNPass ());
-      function_pass_manager.add (llvm::createCFGSimplificationPass ());
-      function_pass_manager.doInitialization ();
+  void
+  llvm_interface::
+  set_optimization_level (octave_jit_optimization_level level)
+  {
+    m_optimizer.set_level (level);
+  }
 
-      // Run the optimizations over all functions in the module being added to
-      // the JIT.
-      std::for_each (mod.begin (), mod.end (), [&](llvm::Function& func) {
-        function_pass_manager.run (func);
-      });
-    });
+  void
+  llvm_interface::
+  append_passes (std::string_view pipeline)
+  {
+    m_optimizer.append_passes (pipeline);
+  }
 
-    return module;
+  void
+  llvm_interface::
+  clear_passes (void)
+  {
+    m_optimizer.clear_passes ();
   }
 
   void
   llvm_interface::
-  handle_lazy_call_through_error (void)
+  set_target_cpu (std::string_view cpu, std::string_view features)
   {
-    throw std::runtime_error ("Missing LLVM function body.");
+    m_optimizer.set_target (cpu, features);
   }
 
   void
   llvm_interface::
-  enable_printing (bool printing)
+  set_vector_library (octave_jit_vector_library lib)
   {
-    m_ast_layer.enable_printing (printing);
+    m_optimizer.set_vector_library (lib);
+  }
+
+  std::string
+  llvm_interface::
+  get_configuration_id (void) const
+  {
+    return m_optimizer.get_configuration_id ();
+  }
+
+  void
+  llvm_interface::
+  enable_object_cache (std::string_view directory, std::size_t max_size)
+  {
+    m_object_cache.enable (directory, max_size);
+  }
+
+  void
+  llvm_interface::
+  disable_object_cache (void)
+  {
+    m_object_cache.disable ();
+  }
+
+  void
+  llvm_interface::
+  enable_jit_registration (void)
+  {
+    std::scoped_lock lock (m_listener_mutex);
+    if (m_perf_map)
+      return;
+
+    m_perf_map = std::make_unique<llvm_perf_map> ();
+
+    if (m_linker == octave_jit_llvm_linker::jitlink)
+    {
+      auto& layer = static_cast<llvm::orc::ObjectLinkingLayer&> (*m_object_layer);
+      layer.addPlugin (std::make_unique<llvm_perf_map_plugin> (*m_perf_map));
+
+      if (auto registrar = llvm::orc::createJITLoaderGDBRegistrar (*m_execution_session))
+      {
+        layer.addPlugin (std::make_unique<llvm::orc::DebugObjectManagerPlugin> (
+          *m_execution_session, std::move (*registrar)));
+      }
+      else
+        llvm::consumeError (registrar.takeError ());
+      return;
+    }
+
+    auto& layer = static_cast<llvm::orc::RTDyldObjectLinkingLayer&> (*m_object_layer);
+    m_perf_map_listener = std::make_unique<llvm_perf_map_listener> (*m_perf_map);
+    layer.registerJITEventListener (*m_perf_map_listener);
+    layer.registerJITEventListener (*llvm::JITEventListener::createGDBRegistrationListener ());
+
+    // This is null unless LLVM was built with perf support.
+    if (auto *perf_listener = llvm::JITEventListener::createPerfJITEventListener ())
+      layer.registerJITEventListener (*perf_listener);
+  }
+
+  void
+  llvm_interface::
+  enable_debug_info (bool enable)
+  {
+    std::scoped_lock lock (m_listener_mutex);
+    if (enable && ! m_debug_map && m_linker == octave_jit_llvm_linker::rtdyld)
+    {
+      m_debug_map = std::make_unique<llvm_debug_map> ();
+      static_cast<llvm::orc::RTDyldObjectLinkingLayer&> (*m_object_layer)
+        .registerJITEventListener (*m_debug_map);
+    }
+    m_ast_layer.enable_debug_info (enable, m_debug_map.get ());
+  }
+
+  std::optional<octave_jit_source_location>
+  llvm_interface::
+  find_source_location (std::uint64_t address) const
+  {
+    llvm_debug_map *debug_map;
+    {
+      std::scoped_lock lock (m_listener_mutex);
+      debug_map = m_debug_map.get ();
+    }
+
+    if (! debug_map)
+      return std::nullopt;
+    return debug_map->find (address);
+  }
+
+  octave_jit_memory_stats
+  llvm_interface::
+  get_memory_stats (void) const
+  {
+    return m_slab_allocator.get_stats ();
+  }
+
+  void
+  llvm_interface::
+  enable_statistics (bool enable)
+  {
+    m_compile_stats.enable (enable);
+  }
+
+  void
+  llvm_interface::
+  reset_statistics (void)
+  {
+    m_compile_stats.reset ();
+  }
+
+  octave_jit_compile_stats
+  llvm_interface::
+  get_statistics (void) const
+  {
+    return m_compile_stats.get ();
+  }
+
+  std::string
+  llvm_interface::
+  get_chrome_trace (void) const
+  {
+    return m_compile_stats.get_chrome_trace ();
   }
 
 }
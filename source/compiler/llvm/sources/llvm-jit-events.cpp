@@ -0,0 +1,152 @@
+/** llvm-jit-events.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "llvm-jit-events.hpp"
+#include "llvm-version.hpp"
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Object/SymbolSize.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/Process.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <ios>
+#include <string>
+
+namespace gch
+{
+
+  //
+  // llvm_perf_map
+  //
+
+  llvm_perf_map::
+  llvm_perf_map (void)
+    : m_stream ("/tmp/perf-" + std::to_string (llvm::sys::Process::getProcessId ()) + ".map",
+                std::ios::app)
+  { }
+
+  void
+  llvm_perf_map::
+  add (std::uint64_t address, std::uint64_t size, llvm::StringRef name)
+  {
+    if (size == 0)
+      return;
+
+    std::scoped_lock lock (m_mutex);
+    m_stream << std::hex << address << ' ' << size << std::dec << ' ' << name.str () << '\n';
+  }
+
+  void
+  llvm_perf_map::
+  flush (void)
+  {
+    std::scoped_lock lock (m_mutex);
+    m_stream.flush ();
+  }
+
+  //
+  // llvm_perf_map_listener
+  //
+
+  llvm_perf_map_listener::
+  llvm_perf_map_listener (llvm_perf_map& perf_map)
+    : m_perf_map (perf_map)
+  { }
+
+  void
+  llvm_perf_map_listener::
+  notifyObjectLoaded (ObjectKey, const llvm::object::ObjectFile& obj,
+                      const llvm::RuntimeDyld::LoadedObjectInfo& info)
+  {
+    // The debug object has its sections relocated to where they were loaded.
+    llvm::object::OwningBinary<llvm::object::ObjectFile> debug_obj = info.getObjectForDebug (obj);
+    if (! debug_obj.getBinary ())
+      return;
+
+    for (const auto& [sym, size] : llvm::object::computeSymbolSizes (*debug_obj.getBinary ()))
+    {
+      llvm::Expected<llvm::object::SymbolRef::Type> type = sym.getType ();
+      if (! type)
+      {
+        llvm::consumeError (type.takeError ());
+        continue;
+      }
+
+      if (*type != llvm::object::SymbolRef::ST_Function)
+        continue;
+
+      llvm::Expected<llvm::StringRef> name    = sym.getName ();
+      llvm::Expected<std::uint64_t>   address = sym.getAddress ();
+      if (! name || ! address)
+      {
+        llvm::consumeError (name.takeError ());
+        llvm::consumeError (address.takeError ());
+        continue;
+      }
+
+      m_perf_map.add (*address, size, *name);
+    }
+    m_perf_map.flush ();
+  }
+
+  //
+  // llvm_perf_map_plugin
+  //
+
+  llvm_perf_map_plugin::
+  llvm_perf_map_plugin (llvm_perf_map& perf_map)
+    : m_perf_map (perf_map)
+  { }
+
+  void
+  llvm_perf_map_plugin::
+  modifyPassConfig (llvm::orc::MaterializationResponsibility&, llvm::jitlink::LinkGraph&,
+                    llvm::jitlink::PassConfiguration& config)
+  {
+    // Addresses are final once fixups have been applied.
+    config.PostFixupPasses.push_back ([this](llvm::jitlink::LinkGraph& graph) {
+      for (const llvm::jitlink::Symbol *sym : graph.defined_symbols ())
+      {
+        if (sym->hasName () && sym->isCallable ())
+        {
+#if GCH_LLVM_VERSION_MAJOR_LESS (14)
+          std::uint64_t address = sym->getAddress ();
+#else
+          std::uint64_t address = sym->getAddress ().getValue ();
+#endif
+          m_perf_map.add (address, sym->getSize (), sym->getName ());
+        }
+      }
+      m_perf_map.flush ();
+      return llvm::Error::success ();
+    });
+  }
+
+  llvm::Error
+  llvm_perf_map_plugin::
+  notifyFailed (llvm::orc::MaterializationResponsibility&)
+  {
+    return llvm::Error::success ();
+  }
+
+  llvm::Error
+  llvm_perf_map_plugin::
+  notifyRemovingResources (llvm::orc::ResourceKey)
+  {
+    return llvm::Error::success ();
+  }
+
+  void
+  llvm_perf_map_plugin::
+  notifyTransferringResources (llvm::orc::ResourceKey, llvm::orc::ResourceKey)
+  { }
+
+}
@@ -0,0 +1,76 @@
+/** llvm-math-intrinsics.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "llvm-math-intrinsics.hpp"
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/IR/Type.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <algorithm>
+#include <iterator>
+
+namespace gch
+{
+
+  struct math_intrinsic
+  {
+    std::string_view    name;
+    llvm::Intrinsic::ID id;
+    unsigned            num_args;
+  };
+
+  // The `double` versions. The `float` versions have the same names with an `f` appended.
+  static constexpr math_intrinsic math_intrinsics[] {
+    { "ceil",      llvm::Intrinsic::ceil,      1 },
+    { "copysign",  llvm::Intrinsic::copysign,  2 },
+    { "cos",       llvm::Intrinsic::cos,       1 },
+    { "exp",       llvm::Intrinsic::exp,       1 },
+    { "exp2",      llvm::Intrinsic::exp2,      1 },
+    { "fabs",      llvm::Intrinsic::fabs,      1 },
+    { "floor",     llvm::Intrinsic::floor,     1 },
+    { "fma",       llvm::Intrinsic::fma,       3 },
+    { "fmax",      llvm::Intrinsic::maxnum,    2 },
+    { "fmin",      llvm::Intrinsic::minnum,    2 },
+    { "log",       llvm::Intrinsic::log,       1 },
+    { "log10",     llvm::Intrinsic::log10,     1 },
+    { "log2",      llvm::Intrinsic::log2,      1 },
+    { "nearbyint", llvm::Intrinsic::nearbyint, 1 },
+    { "pow",       llvm::Intrinsic::pow,       2 },
+    { "rint",      llvm::Intrinsic::rint,      1 },
+    { "round",     llvm::Intrinsic::round,     1 },
+    { "sin",       llvm::Intrinsic::sin,       1 },
+    { "sqrt",      llvm::Intrinsic::sqrt,      1 },
+    { "trunc",     llvm::Intrinsic::trunc,     1 },
+  };
+
+  std::optional<llvm::Intrinsic::ID>
+  find_math_intrinsic (std::string_view name, const llvm::FunctionType& prototype)
+  {
+    // None of the `double` names end with `f`, so this is unambiguous.
+    bool is_float = ! name.empty () && name.back () == 'f';
+    if (is_float)
+      name.remove_suffix (1);
+
+    auto found = std::find_if (std::begin (math_intrinsics), std::end (math_intrinsics),
+                               [&](const math_intrinsic& m) { return m.name == name; });
+    if (found == std::end (math_intrinsics))
+      return std::nullopt;
+
+    llvm::Type *ret_type = prototype.getReturnType ();
+    bool matches = ! prototype.isVarArg ()
+               &&  prototype.getNumParams () == found->num_args
+               &&  (is_float ? ret_type->isFloatTy () : ret_type->isDoubleTy ())
+               &&  std::all_of (prototype.param_begin (), prototype.param_end (),
+                                [&](llvm::Type *ty) { return ty == ret_type; });
+
+    return matches ? std::optional (found->id) : std::nullopt;
+  }
+
+}
@@ -0,0 +1,409 @@
+/** llvm-memory-manager.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "llvm-memory-manager.hpp"
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/Support/Alignment.h>
+#include <llvm/Support/MathExtras.h>
+#include <llvm/Support/Process.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <system_error>
+
+namespace gch
+{
+
+  //
+  // llvm_slab_allocator
+  //
+
+  llvm_slab_allocator::
+  llvm_slab_allocator (std::size_t slab_size)
+    : m_page_size (llvm::sys::Process::getPageSizeEstimate ()),
+      m_slab_size (llvm::alignTo (std::max (slab_size, std::size_t { 1 }), m_page_size))
+  { }
+
+  llvm_slab_allocator::
+  ~llvm_slab_allocator (void)
+  {
+    std::for_each (m_pools.begin (), m_pools.end (), [](pool& p) {
+      std::for_each (p.slabs.begin (), p.slabs.end (), [](llvm::sys::MemoryBlock& slab) {
+        llvm::sys::Memory::releaseMappedMemory (slab);
+      });
+    });
+  }
+
+  auto
+  llvm_slab_allocator::
+  allocate (section_kind kind, std::size_t size)
+    -> range
+  {
+    size = llvm::alignTo (std::max (size, std::size_t { 1 }), m_page_size);
+
+    std::scoped_lock lock (m_mutex);
+    pool& p = get_pool (kind);
+
+    // Best fit, so that large free ranges stay available for large objects.
+    auto found = p.free_ranges.end ();
+    for (auto it = p.free_ranges.begin (); it != p.free_ranges.end (); ++it)
+    {
+      if (size <= it->second && (found == p.free_ranges.end () || it->second < found->second))
+        found = it;
+    }
+
+    if (found == p.free_ranges.end ())
+    {
+      // Mapping near the previous slab keeps the sections of an object within range of the
+      // relocations used by the small code model.
+      std::error_code ec;
+      llvm::sys::MemoryBlock slab = llvm::sys::Memory::allocateMappedMemory (
+        std::max (size, m_slab_size),
+        m_last_slab.base () ? &m_last_slab : nullptr,
+        llvm::sys::Memory::MF_READ | llvm::sys::Memory::MF_WRITE,
+        ec);
+
+      if (ec)
+        return { };
+
+      p.slabs.push_back (slab);
+      p.reserved += slab.allocatedSize ();
+      m_last_slab = slab;
+
+      found = p.free_ranges.emplace (static_cast<std::uint8_t *> (slab.base ()),
+                                     slab.allocatedSize ()).first;
+    }
+
+    range ret { found->first, size };
+    if (size < found->second)
+      p.free_ranges.emplace (found->first + size, found->second - size);
+    p.free_ranges.erase (found);
+
+    p.allocated += size;
+    return ret;
+  }
+
+  void
+  llvm_slab_allocator::
+  deallocate (section_kind kind, range r)
+  {
+    if (r.size == 0)
+      return;
+
+    assert (reinterpret_cast<std::uintptr_t> (r.base) % m_page_size == 0);
+    assert (r.size % m_page_size == 0);
+
+    std::scoped_lock lock (m_mutex);
+    pool& p = get_pool (kind);
+    p.allocated -= r.size;
+
+    // Coalesce with the neighboring free ranges. Ranges from different slabs are never merged,
+    // even if the slabs happen to be adjacent, since each slab is unmapped separately.
+    auto in_same_slab = [&](const std::uint8_t *lhs, const std::uint8_t *rhs) {
+      return std::any_of (p.slabs.begin (), p.slabs.end (), [&](const llvm::sys::MemoryBlock& s) {
+        auto *first = static_cast<const std::uint8_t *> (s.base ());
+        auto *last  = first + s.allocatedSize ();
+        return first <= lhs && lhs < last && first <= rhs && rhs < last;
+      });
+    };
+
+    auto next = p.free_ranges.lower_bound (r.base);
+    if (next != p.free_ranges.end ()
+        &&  next->first == r.base + r.size
+        &&  in_same_slab (r.base, next->first))
+    {
+      r.size += next->second;
+      next = p.free_ranges.erase (next);
+    }
+
+    auto merged = p.free_ranges.end ();
+    if (next != p.free_ranges.begin ())
+    {
+      auto prev = std::prev (next);
+      if (prev->first + prev->second == r.base && in_same_slab (prev->first, r.base))
+      {
+        prev->second += r.size;
+        merged = prev;
+      }
+    }
+
+    if (merged == p.free_ranges.end ())
+      merged = p.free_ranges.emplace_hint (next, r.base, r.size);
+
+    release_if_unused (p, merged);
+  }
+
+  void
+  llvm_slab_allocator::
+  add_used (section_kind kind, std::size_t size)
+  {
+    std::scoped_lock lock (m_mutex);
+    get_pool (kind).used += size;
+  }
+
+  void
+  llvm_slab_allocator::
+  remove_used (section_kind kind, std::size_t size)
+  {
+    std::scoped_lock lock (m_mutex);
+    get_pool (kind).used -= size;
+  }
+
+  std::size_t
+  llvm_slab_allocator::
+  get_page_size (void) const noexcept
+  {
+    return m_page_size;
+  }
+
+  octave_jit_memory_stats
+  llvm_slab_allocator::
+  get_stats (void) const
+  {
+    std::scoped_lock lock (m_mutex);
+    return {
+      get_usage (m_pools[static_cast<std::size_t> (section_kind::code)]),
+      get_usage (m_pools[static_cast<std::size_t> (section_kind::rodata)]),
+      get_usage (m_pools[static_cast<std::size_t> (section_kind::data)])
+    };
+  }
+
+  octave_jit_memory_usage
+  llvm_slab_allocator::
+  get_usage (const pool& p) const
+  {
+    octave_jit_memory_usage usage;
+    usage.reserved  = p.reserved;
+    usage.allocated = p.allocated;
+    usage.used      = p.used;
+
+    std::size_t total_free   = p.reserved - p.allocated;
+    std::size_t largest_free = 0;
+    std::for_each (p.free_ranges.begin (), p.free_ranges.end (), [&](const auto& free_range) {
+      largest_free = std::max (largest_free, free_range.second);
+    });
+
+    if (0 < total_free)
+    {
+      usage.fragmentation = 1.0 - static_cast<double> (largest_free)
+                                / static_cast<double> (total_free);
+    }
+
+    return usage;
+  }
+
+  void
+  llvm_slab_allocator::
+  release_if_unused (pool& p, std::map<std::uint8_t *, std::size_t>::iterator free_range)
+  {
+    // One empty slab is kept so that a session which repeatedly compiles and releases code does
+    // not map and unmap memory each time.
+    if (p.slabs.size () <= 1)
+      return;
+
+    auto slab = std::find_if (p.slabs.begin (), p.slabs.end (),
+                              [&](const llvm::sys::MemoryBlock& s) {
+      return s.base () == free_range->first && s.allocatedSize () == free_range->second;
+    });
+    if (slab == p.slabs.end ())
+      return;
+
+    if (slab->base () == m_last_slab.base ())
+      m_last_slab = p.slabs.front ().base () == slab->base () ? p.slabs.back () : p.slabs.front ();
+
+    p.reserved -= slab->allocatedSize ();
+    p.free_ranges.erase (free_range);
+    llvm::sys::Memory::releaseMappedMemory (*slab);
+    p.slabs.erase (slab);
+  }
+
+  auto
+  llvm_slab_allocator::
+  get_pool (section_kind kind) noexcept
+    -> pool&
+  {
+    return m_pools[static_cast<std::size_t> (kind)];
+  }
+
+  //
+  // llvm_memory_manager
+  //
+
+  llvm_memory_manager::
+  llvm_memory_manager (llvm_slab_allocator& allocator)
+    : m_allocator (allocator)
+  { }
+
+  llvm_memory_manager::
+  ~llvm_memory_manager (void)
+  {
+    for (std::size_t i = 0; i < m_arenas.size (); ++i)
+    {
+      auto   kind = static_cast<section_kind> (i);
+      arena& a    = m_arenas[i];
+
+      // Finalized ranges may no longer be writable.
+      std::for_each (a.ranges.begin (), a.ranges.end (), [&](llvm_slab_allocator::range r) {
+        if (kind != section_kind::data)
+        {
+          llvm::sys::Memory::protectMappedMemory (
+            llvm::sys::MemoryBlock (r.base, r.size),
+            llvm::sys::Memory::MF_READ | llvm::sys::Memory::MF_WRITE);
+        }
+        m_allocator.deallocate (kind, r);
+      });
+
+      m_allocator.remove_used (kind, a.used);
+    }
+  }
+
+  bool
+  llvm_memory_manager::
+  needsToReserveAllocationSpace (void)
+  {
+    return true;
+  }
+
+  void
+  llvm_memory_manager::
+  reserveAllocationSpace (std::uintptr_t code_size,   std::uint32_t code_align,
+                          std::uintptr_t rodata_size, std::uint32_t rodata_align,
+                          std::uintptr_t rwdata_size, std::uint32_t rwdata_align)
+  {
+    // If this fails the sections are allocated on demand instead.
+    if (0 < code_size)
+      reserve (section_kind::code, code_size + code_align);
+    if (0 < rodata_size)
+      reserve (section_kind::rodata, rodata_size + rodata_align);
+    if (0 < rwdata_size)
+      reserve (section_kind::data, rwdata_size + rwdata_align);
+  }
+
+  std::uint8_t *
+  llvm_memory_manager::
+  allocateCodeSection (std::uintptr_t size, unsigned alignment, unsigned, llvm::StringRef)
+  {
+    return allocate_section (section_kind::code, size, alignment);
+  }
+
+  std::uint8_t *
+  llvm_memory_manager::
+  allocateDataSection (std::uintptr_t size, unsigned alignment, unsigned, llvm::StringRef,
+                       bool is_read_only)
+  {
+    return allocate_section (is_read_only ? section_kind::rodata : section_kind::data,
+                             size, alignment);
+  }
+
+  bool
+  llvm_memory_manager::
+  finalizeMemory (std::string *err_msg)
+  {
+    auto protect = [&](section_kind kind, unsigned flags) {
+      trim (kind);
+
+      arena& a = get_arena (kind);
+      return std::all_of (a.ranges.begin (), a.ranges.end (), [&](llvm_slab_allocator::range r) {
+        llvm::sys::MemoryBlock block (r.base, r.size);
+        if (std::error_code ec = llvm::sys::Memory::protectMappedMemory (block, flags))
+        {
+          if (err_msg)
+            *err_msg = ec.message ();
+          return false;
+        }
+
+        if (kind == section_kind::code)
+          llvm::sys::Memory::InvalidateInstructionCache (r.base, r.size);
+        return true;
+      });
+    };
+
+    trim (section_kind::data);
+
+    // Returns true on error.
+    return ! (protect (section_kind::code,
+                       llvm::sys::Memory::MF_READ | llvm::sys::Memory::MF_EXEC)
+          &&  protect (section_kind::rodata, llvm::sys::Memory::MF_READ));
+  }
+
+  std::uint8_t *
+  llvm_memory_manager::
+  allocate_section (section_kind kind, std::uintptr_t size, unsigned alignment)
+  {
+    llvm::Align align (std::max (alignment, 1U));
+    size = std::max (size, std::uintptr_t { 1 });
+
+    arena& a = get_arena (kind);
+    std::uintptr_t addr = llvm::alignAddr (reinterpret_cast<void *> (a.cursor), align);
+    if (a.ranges.empty () || a.end < addr + size)
+    {
+      // The reservation was too small (or there was none). The rest of the current range is
+      // left unused until the object is removed.
+      if (! reserve (kind, size + align.value ()))
+        return nullptr;
+      addr = llvm::alignAddr (reinterpret_cast<void *> (a.cursor), align);
+    }
+
+    a.cursor = addr + size;
+    a.used  += size;
+    m_allocator.add_used (kind, size);
+    return reinterpret_cast<std::uint8_t *> (addr);
+  }
+
+  bool
+  llvm_memory_manager::
+  reserve (section_kind kind, std::uintptr_t size)
+  {
+    llvm_slab_allocator::range r = m_allocator.allocate (kind, size);
+    if (r.base == nullptr)
+      return false;
+
+    arena& a = get_arena (kind);
+    a.ranges.push_back (r);
+    a.cursor = reinterpret_cast<std::uintptr_t> (r.base);
+    a.end    = a.cursor + r.size;
+    return true;
+  }
+
+  void
+  llvm_memory_manager::
+  trim (section_kind kind)
+  {
+    arena& a = get_arena (kind);
+    if (a.ranges.empty ())
+      return;
+
+    std::uintptr_t first_unused = llvm::alignTo (a.cursor, m_allocator.get_page_size ());
+    if (a.end <= first_unused)
+      return;
+
+    llvm_slab_allocator::range& last = a.ranges.back ();
+    std::size_t unused_size = a.end - first_unused;
+
+    m_allocator.deallocate (kind, { reinterpret_cast<std::uint8_t *> (first_unused),
+                                    unused_size });
+
+    last.size -= unused_size;
+    a.end      = first_unused;
+    if (last.size == 0)
+      a.ranges.pop_back ();
+  }
+
+  auto
+  llvm_memory_manager::
+  get_arena (section_kind kind) noexcept
+    -> arena&
+  {
+    return m_arenas[static_cast<std::size_t> (kind)];
+  }
+
+}
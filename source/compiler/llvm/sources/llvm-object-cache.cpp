@@ -0,0 +1,270 @@
+/** llvm-object-cache.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "llvm-object-cache.hpp"
+#include "llvm-runtime-library.hpp"
+
+#include "ir-external-function-info.hpp"
+#include "ir-static-block.hpp"
+#include "ir-static-fingerprint.hpp"
+#include "ir-static-function.hpp"
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/raw_ostream.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace gch
+{
+
+  // Only modules with an identifier carrying this prefix were named by `get_key`.
+  static constexpr std::string_view cache_key_prefix    = "octave-ir-";
+  static constexpr std::string_view cache_key_extension = ".o";
+
+  llvm_object_cache::
+  ~llvm_object_cache (void) = default;
+
+  void
+  llvm_object_cache::
+  enable (std::string_view directory, std::size_t max_size)
+  {
+    if (std::error_code ec = llvm::sys::fs::create_directories (create_twine (directory)))
+    {
+      throw std::runtime_error {
+        "Could not create the object cache directory `" + std::string (directory) + "`: "
+        + ec.message ()
+      };
+    }
+
+    {
+      std::scoped_lock lock (m_mutex);
+      m_directory = directory;
+      m_max_size  = max_size;
+    }
+
+    enforce_size_limit ();
+  }
+
+  void
+  llvm_object_cache::
+  disable (void)
+  {
+    std::scoped_lock lock (m_mutex);
+    m_directory.clear ();
+  }
+
+  bool
+  llvm_object_cache::
+  is_enabled (void) const
+  {
+    std::scoped_lock lock (m_mutex);
+    return ! m_directory.empty ();
+  }
+
+  std::string
+  llvm_object_cache::
+  get_key (const ir_static_function& func, std::string_view configuration_id,
+           const llvm_runtime_library& runtime_library)
+  {
+    return get_key ({ nonnull_ptr { func } }, configuration_id, runtime_library);
+  }
+
+  std::string
+  llvm_object_cache::
+  get_key (const std::vector<nonnull_ptr<const ir_static_function>>& funcs,
+           std::string_view configuration_id, const llvm_runtime_library& runtime_library)
+  {
+    std::string data (configuration_id);
+    data.push_back ('\0');
+
+    // Symbol names are baked into the object, so they are part of the key even though
+    // fingerprints are name-independent.
+    std::for_each (funcs.begin (), funcs.end (), [&](nonnull_ptr<const ir_static_function> func) {
+      data.append (func->get_name ()).push_back ('\0');
+      ir_static_fingerprint fp (*func);
+      data.append (std::to_string (fp.get_data ().size ())).push_back ('\0');
+      data.append (fp.get_data ());
+
+      // Calls to runtime functions are declared with the signature and attributes which they
+      // were registered with in this session.
+      std::for_each (func->begin (), func->end (), [&](const ir_static_block& block) {
+        std::for_each (block.begin (), block.end (), [&](const ir_static_instruction& instr) {
+          if (! is_a<ir_opcode::call> (instr) || instr.empty ())
+            return;
+
+          const auto& callee = as_constant<ir_external_function_info> (instr[0]);
+          data.append (runtime_library.get_declaration_id (callee.get_name ())).push_back ('\0');
+        });
+      });
+    });
+
+    auto digest = llvm::SHA1::hash (llvm::arrayRefFromStringRef (data));
+    return std::string (cache_key_prefix).append (llvm::toHex (digest, true));
+  }
+
+  std::unique_ptr<llvm::MemoryBuffer>
+  llvm_object_cache::
+  find (std::string_view key)
+  {
+    std::string path;
+    {
+      std::scoped_lock lock (m_mutex);
+      if (m_directory.empty ())
+        return nullptr;
+      path = get_path (key);
+    }
+
+    auto buffer = llvm::MemoryBuffer::getFile (path, false, false);
+    if (! buffer)
+      return nullptr;
+
+    // Touch the file so that eviction is least-recently-used rather than oldest-first.
+    int fd;
+    if (! llvm::sys::fs::openFileForWrite (path, fd, llvm::sys::fs::CD_OpenExisting))
+    {
+      static_cast<void> (llvm::sys::fs::setLastAccessAndModificationTime (
+        fd, std::chrono::system_clock::now ()));
+      llvm::sys::Process::SafelyCloseFileDescriptor (fd);
+    }
+
+    return std::move (*buffer);
+  }
+
+  void
+  llvm_object_cache::
+  notifyObjectCompiled (const llvm::Module *module, llvm::MemoryBufferRef obj)
+  {
+    llvm::StringRef id = module->getModuleIdentifier ();
+    if (id.startswith (llvm::StringRef (cache_key_prefix.data (), cache_key_prefix.size ())))
+      store (std::string_view (id.data (), id.size ()), obj);
+  }
+
+  std::unique_ptr<llvm::MemoryBuffer>
+  llvm_object_cache::
+  getObject (const llvm::Module *)
+  {
+    return nullptr;
+  }
+
+  std::string
+  llvm_object_cache::
+  get_path (std::string_view key) const
+  {
+    llvm::SmallString<128> path (m_directory);
+    llvm::sys::path::append (path, create_twine (std::string (key).append (cache_key_extension)));
+    return std::string (path.str ());
+  }
+
+  void
+  llvm_object_cache::
+  store (std::string_view key, llvm::MemoryBufferRef obj)
+  {
+    std::string path;
+    std::string model;
+    {
+      std::scoped_lock lock (m_mutex);
+      if (m_directory.empty ())
+        return;
+      path  = get_path (key);
+      model = get_path ("tmp-%%%%%%%%");
+    }
+
+    // Write to a temporary and rename so that concurrent processes never see a partial object.
+    int fd;
+    llvm::SmallString<128> tmp_path;
+    if (llvm::sys::fs::createUniqueFile (model, fd, tmp_path))
+      return;
+
+    {
+      llvm::raw_fd_ostream out (fd, true);
+      out << obj.getBuffer ();
+      out.close ();
+      if (out.has_error ())
+      {
+        out.clear_error ();
+        static_cast<void> (llvm::sys::fs::remove (tmp_path));
+        return;
+      }
+    }
+
+    if (llvm::sys::fs::rename (tmp_path, path))
+    {
+      static_cast<void> (llvm::sys::fs::remove (tmp_path));
+      return;
+    }
+
+    enforce_size_limit ();
+  }
+
+  void
+  llvm_object_cache::
+  enforce_size_limit (void)
+  {
+    struct entry
+    {
+      std::string            path;
+      std::uint64_t          size;
+      llvm::sys::TimePoint<> last_modified;
+    };
+
+    std::scoped_lock lock (m_mutex);
+    if (m_directory.empty () || m_max_size == 0)
+      return;
+
+    std::vector<entry> entries;
+    std::uint64_t      total_size = 0;
+
+    std::error_code ec;
+    for (llvm::sys::fs::directory_iterator it (m_directory, ec), end; it != end && ! ec;
+         it.increment (ec))
+    {
+      llvm::StringRef name = llvm::sys::path::filename (it->path ());
+      if (! name.startswith (llvm::StringRef (cache_key_prefix.data (), cache_key_prefix.size ()))
+          ||! name.endswith (llvm::StringRef (cache_key_extension.data (),
+                                               cache_key_extension.size ())))
+      {
+        continue;
+      }
+
+      llvm::ErrorOr<llvm::sys::fs::basic_file_status> status = it->status ();
+      if (! status)
+        continue;
+
+      entries.push_back ({ it->path (), status->getSize (), status->getLastModificationTime () });
+      total_size += status->getSize ();
+    }
+
+    if (total_size <= m_max_size)
+      return;
+
+    std::sort (entries.begin (), entries.end (), [](const entry& lhs, const entry& rhs) {
+      return lhs.last_modified < rhs.last_modified;
+    });
+
+    for (auto it = entries.begin (); it != entries.end () && m_max_size < total_size; ++it)
+    {
+      if (! llvm::sys::fs::remove (it->path))
+        total_size -= it->size;
+    }
+  }
+
+}
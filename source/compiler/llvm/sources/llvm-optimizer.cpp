@@ -0,0 +1,428 @@
+/** llvm-optimizer.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "llvm-optimizer.hpp"
+#include "llvm-compile-stats.hpp"
+#include "llvm-version.hpp"
+
+#include "ir-error.hpp"
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/Analysis/CGSCCPassManager.h>
+#include <llvm/Analysis/LoopAnalysisManager.h>
+#include <llvm/ADT/Triple.h>
+#include <llvm/Analysis/TargetLibraryInfo.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/MC/MCSubtargetInfo.h>
+#include <llvm/MC/SubtargetFeature.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Target/TargetMachine.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <utility>
+
+namespace gch
+{
+
+#if GCH_LLVM_VERSION_MAJOR_LESS (14)
+  using llvm_optimization_level = llvm::PassBuilder::OptimizationLevel;
+#else
+  using llvm_optimization_level = llvm::OptimizationLevel;
+#endif
+
+  static
+  llvm_optimization_level
+  get_llvm_optimization_level (octave_jit_optimization_level level)
+  {
+    switch (level)
+    {
+      case octave_jit_optimization_level::O0: return llvm_optimization_level::O0;
+      case octave_jit_optimization_level::O1: return llvm_optimization_level::O1;
+      case octave_jit_optimization_level::O2: return llvm_optimization_level::O2;
+      case octave_jit_optimization_level::O3: return llvm_optimization_level::O3;
+      case octave_jit_optimization_level::Os: return llvm_optimization_level::Os;
+      case octave_jit_optimization_level::Oz: return llvm_optimization_level::Oz;
+    }
+    abort<reason::impossible> ();
+  }
+
+  static
+  llvm::CodeGenOpt::Level
+  get_codegen_level (octave_jit_optimization_level level)
+  {
+    switch (level)
+    {
+      case octave_jit_optimization_level::O0: return llvm::CodeGenOpt::None;
+      case octave_jit_optimization_level::O1: return llvm::CodeGenOpt::Less;
+      case octave_jit_optimization_level::O2: return llvm::CodeGenOpt::Default;
+      case octave_jit_optimization_level::O3: return llvm::CodeGenOpt::Aggressive;
+      case octave_jit_optimization_level::Os: return llvm::CodeGenOpt::Default;
+      case octave_jit_optimization_level::Oz: return llvm::CodeGenOpt::Default;
+    }
+    abort<reason::impossible> ();
+  }
+
+  static
+  const char *
+  get_level_name (octave_jit_optimization_level level)
+  {
+    switch (level)
+    {
+      case octave_jit_optimization_level::O0: return "O0";
+      case octave_jit_optimization_level::O1: return "O1";
+      case octave_jit_optimization_level::O2: return "O2";
+      case octave_jit_optimization_level::O3: return "O3";
+      case octave_jit_optimization_level::Os: return "Os";
+      case octave_jit_optimization_level::Oz: return "Oz";
+    }
+    abort<reason::impossible> ();
+  }
+
+  static
+  const char *
+  get_vector_library_name (octave_jit_vector_library lib)
+  {
+    switch (lib)
+    {
+      case octave_jit_vector_library::none:    return "none";
+      case octave_jit_vector_library::libmvec: return "libmvec";
+      case octave_jit_vector_library::svml:    return "svml";
+    }
+    abort<reason::impossible> ();
+  }
+
+  // Throws `ir_exception` if LLVM knows no variants from the library for the target. Otherwise
+  // the vectorizer would emit calls to symbols which do not exist there.
+  static
+  llvm::TargetLibraryInfoImpl::VectorLibrary
+  get_llvm_vector_library (octave_jit_vector_library lib, const llvm::Triple& triple)
+  {
+    switch (lib)
+    {
+      case octave_jit_vector_library::none:
+        return llvm::TargetLibraryInfoImpl::NoLibrary;
+      case octave_jit_vector_library::libmvec:
+        if (triple.getArch () == llvm::Triple::x86_64)
+          return llvm::TargetLibraryInfoImpl::LIBMVEC_X86;
+        break;
+      case octave_jit_vector_library::svml:
+        if (triple.isX86 ())
+          return llvm::TargetLibraryInfoImpl::SVML;
+        break;
+    }
+    throw ir_exception ("The vector library `" + std::string (get_vector_library_name (lib))
+                        + "` is not available for `" + triple.str () + "`.");
+  }
+
+  static
+  void
+  set_host_target (llvm::orc::JITTargetMachineBuilder& jit_builder)
+  {
+    llvm::SubtargetFeatures features;
+    llvm::StringMap<bool> host_features;
+    if (llvm::sys::getHostCPUFeatures (host_features))
+    {
+      for (const auto& feature : host_features)
+        features.AddFeature (feature.first (), feature.second);
+    }
+
+    jit_builder.setCPU (llvm::sys::getHostCPUName ().str ());
+    jit_builder.getFeatures () = std::move (features);
+  }
+
+  static
+  std::string
+  get_configuration_id (const llvm_optimizer::settings& s)
+  {
+    std::string id = "pipeline-1;";
+    id.append (get_level_name (s.level)).append (";");
+    id.append (s.custom_pipeline).append (";");
+    id.append (get_vector_library_name (s.vector_library)).append (";");
+    id.append (s.jit_builder.getTargetTriple ().str ()).append (";");
+    id.append (s.jit_builder.getCPU ()).append (";");
+    id.append (s.jit_builder.getFeatures ().getString ());
+    return id;
+  }
+
+  //
+  // llvm_optimizer::compiler
+  //
+
+  llvm_optimizer::compiler::
+  compiler (const llvm_optimizer& optimizer, llvm::ObjectCache *object_cache)
+    : IRCompiler (llvm::orc::irManglingOptionsFromTargetOptions (
+                    optimizer.get_settings ()->jit_builder.getOptions ())),
+      m_optimizer    (optimizer),
+      m_object_cache (object_cache)
+  { }
+
+  llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>>
+  llvm_optimizer::compiler::
+  operator() (llvm::Module& module)
+  {
+    return llvm_optimizer::compile (module, *m_optimizer.get_settings (), m_object_cache);
+  }
+
+  //
+  // llvm_optimizer
+  //
+
+  llvm_optimizer::
+  llvm_optimizer (llvm::orc::JITTargetMachineBuilder jit_builder,
+                  octave_jit_optimization_level level)
+  {
+    auto s = std::make_shared<settings> (settings { std::move (jit_builder), level });
+
+    // Without a CPU, code is generated for a generic baseline and never uses wider vectors.
+    set_host_target (s->jit_builder);
+    s->jit_builder.setCodeGenOptLevel (get_codegen_level (level));
+    s->configuration_id = gch::get_configuration_id (*s);
+    m_settings = std::move (s);
+  }
+
+  template <typename Function>
+  void
+  llvm_optimizer::
+  update_settings (Function f)
+  {
+    std::scoped_lock lock (m_mutex);
+    auto s = std::make_shared<settings> (*m_settings);
+    f (*s);
+    s->configuration_id = gch::get_configuration_id (*s);
+    m_settings = std::move (s);
+  }
+
+  void
+  llvm_optimizer::
+  set_level (octave_jit_optimization_level level)
+  {
+    update_settings ([&](settings& s) {
+      s.level = level;
+      s.jit_builder.setCodeGenOptLevel (get_codegen_level (level));
+    });
+  }
+
+  octave_jit_optimization_level
+  llvm_optimizer::
+  get_level (void) const
+  {
+    return get_settings ()->level;
+  }
+
+  void
+  llvm_optimizer::
+  append_passes (std::string_view pipeline)
+  {
+    // Validate up front so that errors are reported to the caller rather than at
+    // materialization.
+    llvm::PassBuilder pass_builder;
+    llvm::ModulePassManager module_pass_manager;
+    llvm::StringRef pipeline_ref (pipeline.data (), pipeline.size ());
+    if (llvm::Error err = pass_builder.parsePassPipeline (module_pass_manager, pipeline_ref))
+    {
+      throw ir_exception ("Invalid pass pipeline `" + std::string (pipeline) + "`: "
+                          + llvm::toString (std::move (err)));
+    }
+
+    update_settings ([&](settings& s) {
+      if (! s.custom_pipeline.empty ())
+        s.custom_pipeline.push_back (',');
+      s.custom_pipeline.append (pipeline);
+    });
+  }
+
+  void
+  llvm_optimizer::
+  clear_passes (void)
+  {
+    update_settings ([](settings& s) { s.custom_pipeline.clear (); });
+  }
+
+  void
+  llvm_optimizer::
+  set_target (std::string_view cpu, std::string_view features)
+  {
+    llvm::orc::JITTargetMachineBuilder jit_builder = get_settings ()->jit_builder;
+    if (cpu.empty ())
+      set_host_target (jit_builder);
+    else
+    {
+      jit_builder.setCPU (std::string (cpu));
+      jit_builder.getFeatures () = llvm::SubtargetFeatures (
+        llvm::StringRef (features.data (), features.size ()));
+
+      auto tm = jit_builder.createTargetMachine ();
+      if (! tm)
+      {
+        throw ir_exception ("Could not create a target machine: "
+                            + llvm::toString (tm.takeError ()));
+      }
+
+      if (! (*tm)->getMCSubtargetInfo ()->isCPUStringValid (jit_builder.getCPU ()))
+        throw ir_exception ("Unrecognized target CPU `" + std::string (cpu) + "`.");
+    }
+
+    // Only the target is taken from the copy, in case the other settings changed meanwhile.
+    update_settings ([&](settings& s) {
+      s.jit_builder.setCPU (jit_builder.getCPU ());
+      s.jit_builder.getFeatures () = jit_builder.getFeatures ();
+    });
+  }
+
+  void
+  llvm_optimizer::
+  set_vector_library (octave_jit_vector_library lib)
+  {
+    // Validate up front so that errors are reported to the caller rather than at
+    // materialization. The target triple never changes.
+    settings_ptr current = get_settings ();
+    static_cast<void> (get_llvm_vector_library (lib, current->jit_builder.getTargetTriple ()));
+    update_settings ([&](settings& s) { s.vector_library = lib; });
+  }
+
+  std::string
+  llvm_optimizer::
+  get_configuration_id (void) const
+  {
+    return get_settings ()->configuration_id;
+  }
+
+  auto
+  llvm_optimizer::
+  get_settings (void) const
+    -> settings_ptr
+  {
+    std::scoped_lock lock (m_mutex);
+    return m_settings;
+  }
+
+  auto
+  llvm_optimizer::
+  create_compiler (llvm::ObjectCache *object_cache) const
+    -> std::unique_ptr<compiler>
+  {
+    return std::make_unique<compiler> (*this, object_cache);
+  }
+
+  llvm::Expected<llvm::orc::ThreadSafeModule>
+  llvm_optimizer::
+  operator() (llvm::orc::ThreadSafeModule module,
+              const llvm::orc::MaterializationResponsibility&) const
+  {
+    if (llvm::Error err = optimize (module))
+      return std::move (err);
+    return module;
+  }
+
+  llvm::Error
+  llvm_optimizer::
+  optimize (llvm::orc::ThreadSafeModule& module) const
+  {
+    return optimize (module, *get_settings ());
+  }
+
+  llvm::Error
+  llvm_optimizer::
+  optimize (llvm::orc::ThreadSafeModule& module, const settings& s)
+  {
+    using clock = llvm_compile_stats::clock;
+    clock::time_point start = llvm_compile_stats::is_active () ? clock::now ()
+                                                               : clock::time_point { };
+
+    auto tm = llvm::orc::JITTargetMachineBuilder (s.jit_builder).createTargetMachine ();
+    if (! tm)
+      return tm.takeError ();
+
+    octave_jit_optimization_level level = s.level;
+    llvm::Error err = module.withModuleDo ([&](llvm::Module& mod) -> llvm::Error {
+      // The vectorizers choose vector widths from the CPU of the target machine.
+      llvm::PipelineTuningOptions tuning;
+      bool vectorize = level == octave_jit_optimization_level::O2
+                   ||  level == octave_jit_optimization_level::O3;
+      tuning.LoopVectorization = vectorize;
+      tuning.SLPVectorization  = vectorize;
+
+      llvm::LoopAnalysisManager     loop_analysis_manager;
+      llvm::FunctionAnalysisManager function_analysis_manager;
+      llvm::CGSCCAnalysisManager    cgscc_analysis_manager;
+      llvm::ModuleAnalysisManager   module_analysis_manager;
+
+      // This must be registered before the defaults, which would otherwise take its place.
+      const llvm::Triple& triple = (*tm)->getTargetTriple ();
+      llvm::TargetLibraryInfoImpl library_info (triple);
+#if GCH_LLVM_VERSION_MAJOR_LESS (17)
+      library_info.addVectorizableFunctionsFromVecLib (
+        get_llvm_vector_library (s.vector_library, triple));
+#else
+      library_info.addVectorizableFunctionsFromVecLib (
+        get_llvm_vector_library (s.vector_library, triple), triple);
+#endif
+      function_analysis_manager.registerPass ([&] {
+        return llvm::TargetLibraryAnalysis (library_info);
+      });
+
+      llvm::PassBuilder pass_builder (tm->get (), tuning);
+      pass_builder.registerModuleAnalyses (module_analysis_manager);
+      pass_builder.registerCGSCCAnalyses (cgscc_analysis_manager);
+      pass_builder.registerFunctionAnalyses (function_analysis_manager);
+      pass_builder.registerLoopAnalyses (loop_analysis_manager);
+      pass_builder.crossRegisterProxies (loop_analysis_manager, function_analysis_manager,
+                                         cgscc_analysis_manager, module_analysis_manager);
+
+      llvm_optimization_level llvm_level = get_llvm_optimization_level (level);
+      llvm::ModulePassManager module_pass_manager =
+        (level == octave_jit_optimization_level::O0)
+          ? pass_builder.buildO0DefaultPipeline (llvm_level)
+          : pass_builder.buildPerModuleDefaultPipeline (llvm_level);
+
+      if (! s.custom_pipeline.empty ())
+      {
+        if (llvm::Error perr = pass_builder.parsePassPipeline (module_pass_manager,
+                                                               s.custom_pipeline))
+        {
+          return perr;
+        }
+      }
+
+      module_pass_manager.run (mod, module_analysis_manager);
+      return llvm::Error::success ();
+    });
+
+    if (! err && llvm_compile_stats::is_active ())
+      llvm_compile_stats::record (octave_jit_compile_phase::optimize, start, clock::now ());
+    return err;
+  }
+
+  llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>>
+  llvm_optimizer::
+  compile (llvm::Module& module, const settings& s, llvm::ObjectCache *object_cache)
+  {
+    // Like `ConcurrentIRCompiler`, a target machine is created per module so that modules may be
+    // compiled concurrently.
+    auto tm = llvm::orc::JITTargetMachineBuilder (s.jit_builder).createTargetMachine ();
+    if (! tm)
+      return tm.takeError ();
+
+    if (! llvm_compile_stats::is_active ())
+      return llvm::orc::SimpleCompiler (**tm, object_cache) (module);
+
+    llvm_compile_stats::clock::time_point start = llvm_compile_stats::clock::now ();
+    auto obj = llvm::orc::SimpleCompiler (**tm, object_cache) (module);
+    llvm_compile_stats::record (octave_jit_compile_phase::codegen, start,
+                                llvm_compile_stats::clock::now ());
+    if (obj)
+      llvm_compile_stats::record_code (**obj);
+    return obj;
+  }
+
+}
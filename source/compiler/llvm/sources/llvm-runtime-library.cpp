@@ -0,0 +1,66 @@
+/** llvm-runtime-library.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "llvm-runtime-library.hpp"
+
+#include "ir-type-util.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace gch
+{
+
+  void
+  llvm_runtime_library::
+  add (octave_jit_runtime_function func)
+  {
+    std::scoped_lock lock (m_mutex);
+    // The symbol could not have been defined twice, so the name is new.
+    std::string name = func.name;
+    m_functions.try_emplace (std::move (name), std::move (func));
+  }
+
+  const octave_jit_runtime_function *
+  llvm_runtime_library::
+  find (std::string_view name) const
+  {
+    std::scoped_lock lock (m_mutex);
+    auto found = m_functions.find (std::string (name));
+    return (found != m_functions.end ()) ? &found->second : nullptr;
+  }
+
+  std::string
+  llvm_runtime_library::
+  get_declaration_id (std::string_view name) const
+  {
+    const octave_jit_runtime_function *func = find (name);
+    if (! func)
+      return { };
+
+    // For example `int (int, ...) nothrow`.
+    std::string id = get_name (func->return_type);
+    id.append (" (");
+    std::for_each (func->arg_types.begin (), func->arg_types.end (), [&](ir_type ty) {
+      if (id.back () != '(')
+        id.append (", ");
+      id.append (get_name (ty));
+    });
+    if (func->is_variadic)
+      id.append (id.back () == '(' ? "..." : ", ...");
+    id.append (")");
+
+    if (func->attributes.does_not_throw)
+      id.append (" nothrow");
+    if (func->attributes.does_not_return)
+      id.append (" noreturn");
+    if (func->attributes.does_not_access_memory)
+      id.append (" readnone");
+    return id;
+  }
+
+}
@@ -7,8 +7,12 @@
 
 #include "llvm-common.hpp"
 #include "llvm-constant.hpp"
+#include "llvm-math-intrinsics.hpp"
+#include "llvm-runtime-library.hpp"
 #include "llvm-value-map.hpp"
+#include "llvm-version.hpp"
 
+#include "ir-error.hpp"
 #include "ir-static-block.hpp"
 #include "ir-static-def.hpp"
 #include "ir-static-function.hpp"
@@ -36,6 +40,7 @@ GCH_ENABLE_WARNINGS_MSVC
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <type_traits>
@@ -45,7 +50,6 @@ GCH_ENABLE_WARNINGS_MSVC
 
 namespace llvm
 {
-  class AllocaInst;
   class Function;
   class LLVMContext;
   class Type;
@@ -60,9 +64,8 @@ namespace gch
   //
 
   llvm_def_map::
-  llvm_def_map (llvm::AllocaInst& alloc, std::size_t num_defs)
-    : m_llvm_alloc (alloc),
-      m_llvm_defs  (num_defs)
+  llvm_def_map (std::size_t num_defs)
+    : m_llvm_defs (num_defs)
   { }
 
   llvm::Value&
@@ -73,13 +76,6 @@ namespace gch
     return m_llvm_defs[id].emplace (llvm_value);
   }
 
-  llvm::AllocaInst&
-  llvm_def_map::
-  get_allocation (void) const noexcept
-  {
-    return *m_llvm_alloc;
-  }
-
   llvm::Value&
   llvm_def_map::
   operator[] (ir_def_id id) const
@@ -89,11 +85,14 @@ namespace gch
   }
 
   llvm_module_interface::
-  llvm_module_interface (llvm_module_type& llvm_module)
-    : m_llvm_module (llvm_module),
-      m_type_map    (generate_ir_type_map<llvm_type_getter_map> (*this)),
-      m_true_value  (*invoke_with_context (&llvm::ConstantInt::getTrue)),
-      m_false_value (*invoke_with_context (&llvm::ConstantInt::getFalse))
+  llvm_module_interface (llvm_module_type& llvm_module, llvm::DIBuilder *debug_builder,
+                         const llvm_runtime_library *runtime_library)
+    : m_llvm_module     (llvm_module),
+      m_type_map        (generate_ir_type_map<llvm_type_getter_map> (*this)),
+      m_true_value      (*invoke_with_context (&llvm::ConstantInt::getTrue)),
+      m_false_value     (*invoke_with_context (&llvm::ConstantInt::getFalse)),
+      m_debug_builder   (debug_builder),
+      m_runtime_library (runtime_library)
   { }
 
   llvm::Type&
@@ -128,61 +127,150 @@ namespace gch
 
   optional_ref<llvm::Function>
   llvm_module_interface::
-  get_external_function (std::string_view name, llvm::FunctionType& prototype)
+  get_external_function (std::string_view name, llvm::FunctionType& prototype,
+                         const ir_external_function_info::attributes& attrs)
   {
-    struct key_pair
+    if (const octave_jit_runtime_function *runtime_func =
+          m_runtime_library ? m_runtime_library->find (name) : nullptr)
     {
-      std::string                     name;
-      nonnull_ptr<llvm::FunctionType> prototype;
-    };
+      return get_runtime_function (*runtime_func, prototype);
+    }
 
-    struct key_hash
-    {
-      std::size_t
-      operator() (const key_pair& pair) const
+    // The fixed parameters of a variadic function are not known, so it is declared with none.
+    // Every argument is then passed through the ellipsis, and calls with different arguments
+    // share the declaration.
+    llvm::FunctionType& declared_ty = prototype.isVarArg ()
+                                    ? *llvm::FunctionType::get (prototype.getReturnType (), true)
+                                    : prototype;
+
+    // Declarations are looked up in the module itself. A process-wide map would be shared by
+    // modules being translated concurrently, and it would hold onto functions belonging to
+    // contexts which have since been destroyed.
+    return invoke_with_module ([&](llvm::Module& module) {
+      llvm::StringRef llvm_name (name.data (), name.size ());
+      if (llvm::Function *func = module.getFunction (llvm_name))
       {
-        std::size_t name_hash = std::hash<std::string> {} (pair.name);
-        std::size_t proto_hash = std::hash<nonnull_ptr<llvm::FunctionType>> { } (pair.prototype);
-        return name_hash ^ (proto_hash + 0x9E3779B9 + (name_hash << 6) + (name_hash >> 2));
+        // Another declaration would be renamed by LLVM, and then fail to link.
+        if (func->getFunctionType () != &declared_ty)
+        {
+          throw ir_exception ("The external function `" + std::string (name)
+                              + "` is called with conflicting signatures.");
+        }
+        return func;
       }
-    };
 
-    struct key_equal
-    {
-      bool
-      operator() (const key_pair& lhs, const key_pair& rhs) const
-      {
-        return lhs.name == rhs.name && lhs.prototype == rhs.prototype;
-      }
-    };
+      llvm::Function *func = llvm::Function::Create (&declared_ty, llvm::Function::ExternalLinkage,
+                                                     llvm_name, module);
+      add_llvm_attributes (*func, attrs);
+      return func;
+    });
+  }
 
-    using map_type = std::unordered_map<key_pair,
-                                        optional_ref<llvm::Function>,
-                                        key_hash,
-                                        key_equal>;
+  optional_ref<llvm::Function>
+  llvm_module_interface::
+  get_math_intrinsic (std::string_view name, llvm::FunctionType& prototype)
+  {
+    if (m_runtime_library && m_runtime_library->find (name))
+      return nullopt;
+
+    std::optional<llvm::Intrinsic::ID> id = find_math_intrinsic (name, prototype);
+    if (! id)
+      return nullopt;
+
+    // The intrinsics are overloaded on their floating-point type.
+    return invoke_with_module ([&](llvm::Module& module) {
+#if GCH_LLVM_VERSION_MAJOR_LESS (20)
+      return llvm::Intrinsic::getDeclaration (&module, *id, { prototype.getReturnType () });
+#else
+      return llvm::Intrinsic::getOrInsertDeclaration (&module, *id,
+                                                      { prototype.getReturnType () });
+#endif
+    });
+  }
 
-    // The function name/prototype map is a singleton since LLVM loads each external function
-    // once per thread.
-    static std::unique_ptr<map_type> map;
-    if (! map)
-      map = std::make_unique<map_type> ();
+  llvm::Function&
+  llvm_module_interface::
+  get_runtime_function (const octave_jit_runtime_function& runtime_func,
+                        llvm::FunctionType& prototype)
+  {
+    llvm::SmallVector<llvm::Type *> arg_types;
+    std::transform (runtime_func.arg_types.begin (), runtime_func.arg_types.end (),
+                    std::back_inserter (arg_types), [&](ir_type ty) { return &get_llvm_type (ty); });
+
+    llvm::FunctionType& registered_ty = *llvm::FunctionType::get (
+      &get_llvm_type (runtime_func.return_type),
+      arg_types,
+      runtime_func.is_variadic);
+
+    // Arguments passed through the ellipsis of a variadic function are part of the prototype at
+    // the call site, so only the named parameters are compared.
+    unsigned num_params = registered_ty.getNumParams ();
+    bool     matches    = prototype.getReturnType () == registered_ty.getReturnType ()
+                      &&  prototype.isVarArg () == registered_ty.isVarArg ()
+                      &&  (registered_ty.isVarArg () ? prototype.getNumParams () >= num_params
+                                                     : prototype.getNumParams () == num_params)
+                      &&  std::equal (registered_ty.param_begin (), registered_ty.param_end (),
+                                      prototype.param_begin ());
+    if (! matches)
+    {
+      throw std::logic_error ("The runtime function `" + runtime_func.name
+                              + "` is called with a different signature than it has.");
+    }
 
-    auto [it, ins] = map->try_emplace (key_pair { std::string (name), nonnull_ptr { prototype } });
+    return *invoke_with_module ([&](llvm::Module& module) {
+      llvm::StringRef llvm_name (runtime_func.name);
+      if (llvm::Function *func = module.getFunction (llvm_name))
+      {
+        // The name may already be taken by a declaration which did not come from the library.
+        if (func->getFunctionType () != &registered_ty)
+        {
+          throw std::logic_error ("The runtime function `" + runtime_func.name
+                                  + "` conflicts with another declaration of the same name.");
+        }
+        return func;
+      }
 
-    optional_ref<llvm::Function>& ret = it->second;
+      llvm::Function *func = llvm::Function::Create (&registered_ty,
+                                                     llvm::Function::ExternalLinkage, llvm_name,
+                                                     module);
+
+      const octave_jit_runtime_attributes& attrs = runtime_func.attributes;
+      if (attrs.does_not_throw)
+        func->setDoesNotThrow ();
+      if (attrs.does_not_return)
+        func->setDoesNotReturn ();
+      if (attrs.does_not_access_memory)
+        func->setDoesNotAccessMemory ();
+      return func;
+    });
+  }
 
-    if (ins)
-    {
-      ret.emplace (invoke_with_module ([&](llvm::Module& module) {
-        return llvm::Function::Create (
-          &prototype,
-          llvm::Function::ExternalLinkage,
-          create_twine (name),
-          module);
-      }));
-    }
+  llvm::Function&
+  llvm_module_interface::
+  get_jit_function (std::string_view name, llvm::FunctionType& prototype)
+  {
+    return *invoke_with_module ([&](llvm::Module& module) {
+      llvm::StringRef llvm_name (name.data (), name.size ());
+      llvm::Function *func = module.getFunction (llvm_name);
+      if (! func)
+        return llvm::Function::Create (&prototype, llvm::Function::ExternalLinkage, llvm_name,
+                                       module);
+
+      // Unlike an external function, there is only one definition which it could refer to.
+      if (func->getFunctionType () != &prototype)
+      {
+        throw std::logic_error ("The function `" + std::string (name)
+                                + "` is called with a different signature than it has.");
+      }
+      return func;
+    });
+  }
 
-    return ret;
+  llvm::DIBuilder *
+  llvm_module_interface::
+  get_debug_builder (void) const noexcept
+  {
+    return m_debug_builder;
   }
 
   //
@@ -196,37 +284,21 @@ namespace gch
       m_llvm_function (llvm_func),
       m_function      (func)
   {
-    llvm_ir_builder_type builder {
-      invoke_with_context ([](llvm::LLVMContext& ctx) {
-        return llvm_ir_builder_type { ctx };
-      })
-    };
-
     m_blocks.reserve (func.num_blocks ());
 
-    // init entry block
-    llvm::BasicBlock& first_block = create_block (func.get_block_name (func.front ()));
-    m_blocks.emplace_back (&first_block);
-    builder.SetInsertPoint (&first_block);
-
-    // init variables
+    // init variables (defs are SSA values, so no storage is allocated for them)
     std::for_each (func.variables_begin (), func.variables_end (),
                    [&](const ir_static_variable& var) {
-      llvm::Type& ty   = get_llvm_type (var.get_type ());
-      llvm::Twine name = create_twine (var.get_name ());
       std::size_t num_defs = var.get_num_defs ();
       if (0 < num_defs)
       {
         assert (ir_type_v<void> != var.get_type () && "Variable cannot have type void.");
-        m_var_map.try_emplace (
-          nonnull_ptr { var },
-          *builder.CreateAlloca (&ty, nullptr, name),
-          num_defs);
+        m_var_map.try_emplace (nonnull_ptr { var }, num_defs);
       }
     });
 
     // init blocks
-    std::transform (std::next (func.begin ()), func.end (), std::back_inserter (m_blocks),
+    std::transform (func.begin (), func.end (), std::back_inserter (m_blocks),
                     [&](const ir_static_block& block) {
                       return &create_block (func.get_block_name (block));
                     });
@@ -253,22 +325,6 @@ namespace gch
     return (*this)[ir_block_id (static_cast<size_ty> (off))];
   }
 
-  llvm::AllocaInst&
-  llvm_value_map::
-  operator[] (const ir_static_variable& var) const
-  {
-    auto found = m_var_map.find (nonnull_ptr { var });
-    assert (found != m_var_map.end ());
-    return found->second.get_allocation ();
-  }
-
-  llvm::AllocaInst&
-  llvm_value_map::
-  operator[] (ir_static_def def) const
-  {
-    return operator[] (m_function.get_variable (def));
-  }
-
   llvm::Value&
   llvm_value_map::
   operator[] (ir_static_use use)
@@ -7,29 +7,983 @@
 
 #include "gch/octave-ir-compiler-llvm.hpp"
 
+#include "llvm-compile-queue.hpp"
 #include "llvm-interface.hpp"
 
+#include "ir-error.hpp"
+#include "ir-external-function-info.hpp"
+#include "ir-static-block.hpp"
+#include "ir-type-util.hpp"
+
+GCH_DISABLE_WARNINGS_MSVC
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+GCH_ENABLE_WARNINGS_MSVC
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
 #include <iostream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
 
 namespace gch
 {
 
+  struct octave_jit_compiler_llvm::compiled_unit
+  {
+    // Whether the symbol would outlive the name, since other names still refer to the code.
+    [[nodiscard]]
+    bool
+    would_orphan (std::string_view name) const
+    {
+      return names.size () > 1
+         &&  std::find (symbols.begin (), symbols.end (), name) != symbols.end ();
+    }
+
+    std::vector<llvm::orc::ResourceTrackerSP>                     trackers;
+    std::vector<ir_static_fingerprint>                            fingerprints;
+    std::vector<std::string>                                      symbols;
+    std::vector<std::string>                                      names;
+    std::unordered_map<std::string, llvm::orc::ResourceTrackerSP> aliases;  // Keyed by name.
+    bool                                                          released = false;
+  };
+
+  // The header is followed by the configuration which the object was compiled for, then by one
+  // line for each function.
+  static constexpr const char *manifest_header = "octave-ir manifest 2";
+
+  static
+  std::string
+  get_manifest_path (std::string_view path)
+  {
+    return std::string (path) + ".manifest";
+  }
+
+  // For example `double (double, double)`.
+  static
+  std::string
+  get_signature (const ir_static_function& func)
+  {
+    std::string ret = func.has_returns () ? get_name (func.get_type (*func.returns_begin ()))
+                                          : get_name (ir_type_v<void>);
+    ret.append (" (");
+    std::for_each (func.args_begin (), func.args_end (), [&](ir_variable_id id) {
+      if (ret.back () != '(')
+        ret.append (", ");
+      ret.append (get_name (func.get_type (id)));
+    });
+    ret.append (")");
+    return ret;
+  }
+
+  // Writes through a temporary file and a rename, so that readers never see a partial file.
+  static
+  void
+  write_file (const std::string& path, llvm::StringRef contents)
+  {
+    int                    fd;
+    llvm::SmallString<128> tmp_path;
+    if (std::error_code ec = llvm::sys::fs::createUniqueFile (path + ".tmp-%%%%%%%%", fd,
+                                                              tmp_path))
+    {
+      throw ir_exception ("Could not create a temporary file for `" + path + "`: "
+                          + ec.message ());
+    }
+
+    {
+      llvm::raw_fd_ostream out (fd, true);
+      out << contents;
+      out.close ();
+      if (out.has_error ())
+      {
+        std::error_code ec = out.error ();
+        out.clear_error ();
+        static_cast<void> (llvm::sys::fs::remove (tmp_path));
+        throw ir_exception ("Could not write `" + path + "`: " + ec.message ());
+      }
+    }
+
+    if (std::error_code ec = llvm::sys::fs::rename (tmp_path, path))
+    {
+      static_cast<void> (llvm::sys::fs::remove (tmp_path));
+      throw ir_exception ("Could not write `" + path + "`: " + ec.message ());
+    }
+  }
+
+  static
+  std::string
+  get_version_name (std::string_view name, std::size_t generation)
+  {
+    return std::string (name) + "#" + std::to_string (generation);
+  }
+
+  // Failures from the JIT are reported as exceptions so that the callers can clean up.
+  static
+  void
+  throw_if_error (llvm::Error err, const std::string& what)
+  {
+    if (err)
+      throw ir_exception (what + ": " + llvm::toString (std::move (err)));
+  }
+
+  template <typename T>
+  static
+  T
+  throw_if_error (llvm::Expected<T> expected, const std::string& what)
+  {
+    throw_if_error (expected.takeError (), what);
+    return std::move (*expected);
+  }
+
+  [[noreturn]]
+  static
+  void
+  throw_shared_symbol (std::string_view name)
+  {
+    throw ir_exception ("Cannot redefine `" + std::string (name) + "`, since its code is shared "
+                        "with another function which is still compiled.");
+  }
+
   octave_jit_compiler_llvm::
   octave_jit_compiler_llvm (void)
-    : m_interface (llvm::cantFail (llvm_interface::create ()))
+    : octave_jit_compiler_llvm (get_default_linker ())
+  { }
+
+  octave_jit_compiler_llvm::
+  octave_jit_compiler_llvm (octave_jit_llvm_linker linker)
+    : octave_jit_compiler_llvm (std::thread::hardware_concurrency (), 256, linker)
+  { }
+
+  octave_jit_compiler_llvm::
+  octave_jit_compiler_llvm (std::size_t num_async_workers, std::size_t async_queue_capacity)
+    : octave_jit_compiler_llvm (num_async_workers, async_queue_capacity, get_default_linker ())
+  { }
+
+  octave_jit_compiler_llvm::
+  octave_jit_compiler_llvm (std::size_t num_async_workers, std::size_t async_queue_capacity,
+                            octave_jit_llvm_linker linker)
+    : m_interface            (llvm::cantFail (llvm_interface::create (linker))),
+      m_num_async_workers    (num_async_workers),
+      m_async_queue_capacity (async_queue_capacity)
   { }
 
   octave_jit_compiler_llvm::
   ~octave_jit_compiler_llvm (void) = default;
 
+  octave_jit_llvm_linker
+  octave_jit_compiler_llvm::
+  get_default_linker (void) noexcept
+  {
+#ifdef GCH_OCTAVE_IR_USE_JITLINK
+    return octave_jit_llvm_linker::jitlink;
+#else
+    return octave_jit_llvm_linker::rtdyld;
+#endif
+  }
+
   void *
   octave_jit_compiler_llvm::
   compile (const ir_static_function& func)
   {
-    llvm::ExitOnError exit_on_error { };
-    exit_on_error (m_interface->add_ast (func));
-    auto sym = exit_on_error (m_interface->find_symbol (func.get_name ()));
-    return reinterpret_cast<void *> (sym.getAddress ());
+    check_jit_callees ({ nonnull_ptr { func } });
+    return find_or_compile (func.get_name (), ir_static_fingerprint (func),
+                            [&](compiled_unit& unit) {
+      llvm::orc::ResourceTrackerSP& tracker =
+        unit.trackers.emplace_back (m_interface->create_resource_tracker ());
+
+      std::string what = "Could not compile `" + std::string (func.get_name ()) + "`";
+      throw_if_error (m_interface->add_ast (func, tracker), what);
+      auto sym = throw_if_error (m_interface->find_symbol (func.get_name ()), what);
+      return reinterpret_cast<void *> (sym.getAddress ());
+    });
+  }
+
+  std::vector<void *>
+  octave_jit_compiler_llvm::
+  compile_batch (const function_refs& funcs)
+  {
+    // Functions which are already compiled (or are duplicated within the batch) are resolved
+    // from the dedup table. The rest are translated together as one module.
+    // The new functions are emitted together, so they are also freed together.
+    std::vector<compiled_function>    results;
+    std::vector<std::promise<void *>> new_promises;
+    function_refs                     new_funcs;
+    auto                              new_unit = std::make_shared<compiled_unit> ();
+
+    check_jit_callees (funcs);
+
+    std::vector<ir_static_fingerprint> fps;
+    fps.reserve (funcs.size ());
+    std::transform (funcs.begin (), funcs.end (), std::back_inserter (fps),
+                    [](nonnull_ptr<const ir_static_function> f) {
+      return ir_static_fingerprint (*f);
+    });
+
+    {
+      std::scoped_lock lock (m_compiled_mutex);
+
+      // Every member is checked before the table is modified, so that no entry is left waiting on
+      // a batch which never compiles.
+      for (std::size_t i = 0; i < funcs.size (); ++i)
+      {
+        std::string_view name = funcs[i]->get_name ();
+        if (m_published.find (std::string (name)) != m_published.end ())
+        {
+          throw ir_exception ("Cannot compile `" + std::string (name)
+                              + "`, since it is published.");
+        }
+
+        if (m_compiled.find (fps[i]) == m_compiled.end ())
+          check_symbol_available (name);
+      }
+
+      for (std::size_t i = 0; i < funcs.size (); ++i)
+      {
+        if (auto found = m_compiled.find (fps[i]); found != m_compiled.end ())
+          results.push_back (found->second);
+        else
+        {
+          std::promise<void *>& promise = new_promises.emplace_back ();
+          compiled_function compiled { promise.get_future ().share (), new_unit,
+                                       std::string (funcs[i]->get_name ()) };
+          results.push_back (m_compiled.try_emplace (fps[i], std::move (compiled)).first->second);
+          new_unit->fingerprints.push_back (fps[i]);
+          new_unit->symbols.emplace_back (funcs[i]->get_name ());
+          new_funcs.push_back (funcs[i]);
+        }
+      }
+    }
+
+    std::vector<void *> ret (results.size (), nullptr);
+    try
+    {
+      // Members resolved from code compiled earlier are named before the batch is linked, since
+      // the other members may call them. A member which was deduplicated against code released
+      // in the meantime is compiled on its own instead.
+      for (std::size_t i = 0; i < results.size (); ++i)
+      {
+        if (results[i].unit == new_unit)
+          continue;
+
+        ret[i] = results[i].address.get ();
+        if (! register_name (funcs[i]->get_name (), results[i].unit, ret[i], results[i].symbol))
+          ret[i] = compile (*funcs[i]);
+      }
+
+      if (! new_funcs.empty ())
+      {
+        std::vector<std::string_view> names;
+        names.reserve (new_funcs.size ());
+        std::transform (new_funcs.begin (), new_funcs.end (), std::back_inserter (names),
+                        [](nonnull_ptr<const ir_static_function> f) { return f->get_name (); });
+
+        llvm::orc::ResourceTrackerSP& tracker =
+          new_unit->trackers.emplace_back (m_interface->create_resource_tracker ());
+
+        // Members duplicated within the batch are aliases of the first member with their body.
+        // Each alias is released along with its name.
+        std::string what = "Could not compile the batch";
+        for (std::size_t i = 0; i < results.size (); ++i)
+        {
+          std::string_view name = funcs[i]->get_name ();
+          if (results[i].unit != new_unit || results[i].symbol == name)
+            continue;
+
+          llvm::orc::ResourceTrackerSP alias_tracker = m_interface->create_resource_tracker ();
+          throw_if_error (m_interface->add_alias (name, results[i].symbol, alias_tracker), what);
+          new_unit->aliases.emplace (name, std::move (alias_tracker));
+        }
+
+        throw_if_error (m_interface->add_ast (new_funcs, tracker), what);
+        auto syms = throw_if_error (m_interface->find_symbols (names), what);
+
+        for (std::size_t i = 0; i < syms.size (); ++i)
+          new_promises[i].set_value (reinterpret_cast<void *> (syms[i].getAddress ()));
+      }
+    }
+    catch (...)
+    {
+      {
+        std::scoped_lock lock (m_compiled_mutex);
+        std::for_each (new_unit->fingerprints.begin (), new_unit->fingerprints.end (),
+                       [&](const ir_static_fingerprint& fp) { m_compiled.erase (fp); });
+      }
+      // Waiters are released first, since the cleanup may fail as well.
+      std::for_each (new_promises.begin (), new_promises.end (), [](std::promise<void *>& p) {
+        p.set_exception (std::current_exception ());
+      });
+      remove_unit (*new_unit);
+      throw;
+    }
+
+    // The symbols of the new members (and their aliases) are already defined.
+    for (std::size_t i = 0; i < results.size (); ++i)
+    {
+      if (results[i].unit != new_unit)
+        continue;
+
+      ret[i] = results[i].address.get ();
+      register_name (funcs[i]->get_name (), new_unit, ret[i], results[i].symbol);
+    }
+    return ret;
+  }
+
+  void *
+  octave_jit_compiler_llvm::
+  compile_map (const ir_static_function& func)
+  {
+    return compile_entry (func, llvm_entry_kind::map);
+  }
+
+  void *
+  octave_jit_compiler_llvm::
+  compile_boxed (const ir_static_function& func)
+  {
+    return compile_entry (func, llvm_entry_kind::boxed);
+  }
+
+  void *
+  octave_jit_compiler_llvm::
+  compile_lazy (ir_static_function&& func)
+  {
+    check_jit_callees ({ nonnull_ptr { func } });
+
+    std::string name (func.get_name ());
+    return find_or_compile (name, ir_static_fingerprint (func), [&](compiled_unit& unit) {
+      llvm::orc::ResourceTrackerSP& stub_tracker =
+        unit.trackers.emplace_back (m_interface->create_resource_tracker ());
+      llvm::orc::ResourceTrackerSP& body_tracker =
+        unit.trackers.emplace_back (m_interface->create_lazy_resource_tracker ());
+
+      std::string what = "Could not create the lazy stub for `" + name + "`";
+      throw_if_error (m_interface->add_lazy_ast (std::move (func), stub_tracker, body_tracker),
+                      what);
+      auto sym = throw_if_error (m_interface->find_symbol (name), what);
+      return reinterpret_cast<void *> (sym.getAddress ());
+    });
+  }
+
+  octave_jit_compile_handle
+  octave_jit_compiler_llvm::
+  compile_async (ir_static_function&& func, int priority)
+  {
+    std::call_once (m_compile_queue_flag, [&] {
+      m_compile_queue = std::make_unique<llvm_compile_queue> (
+        [this](const ir_static_function& f) { return compile (f); },
+        m_num_async_workers,
+        m_async_queue_capacity);
+    });
+
+    return m_compile_queue->submit (std::move (func), priority);
+  }
+
+  bool
+  octave_jit_compiler_llvm::
+  release (std::string_view name)
+  {
+    compiled_unit garbage;
+    {
+      std::scoped_lock lock (m_compiled_mutex);
+      auto found = m_named_units.find (std::string (name));
+      if (found == m_named_units.end ())
+        return false;
+
+      // The entry point of a published function must never be left dangling.
+      if (is_current_version (name))
+        return false;
+
+      release_name (found, garbage);
+    }
+
+    remove_unit (garbage);
+    return true;
+  }
+
+  void *
+  octave_jit_compiler_llvm::
+  replace (ir_static_function&& func)
+  {
+    std::string name (func.get_name ());
+    std::string replacement_name;
+    {
+      std::scoped_lock lock (m_compiled_mutex);
+      if (m_published.find (name) != m_published.end ())
+        throw ir_exception ("Cannot replace `" + name + "`, since it is published.");
+
+      if (auto old = m_named_units.find (name); old != m_named_units.end ())
+      {
+        // An identical body needs no new code.
+        auto found = m_compiled.find (ir_static_fingerprint (func));
+        if (found != m_compiled.end () && found->second.unit == old->second.unit)
+          return old->second.address;
+
+        if (old->second.unit->would_orphan (name))
+          throw_shared_symbol (name);
+
+        replacement_name = name + ".replacement#" + std::to_string (++m_num_replacements);
+      }
+    }
+
+    if (replacement_name.empty ())
+      return compile (func);
+
+    // The new body is compiled under a name of its own first, so that it does not collide with
+    // the old one, which stays in place if compilation fails.
+    void *addr = compile (ir_static_function (std::move (func), replacement_name));
+
+    // The old definition is released and the new one takes its name under the same lock, so that
+    // the name is never missing or taken by another definition in between.
+    compiled_unit garbage;
+    std::exception_ptr error;
+    {
+      std::scoped_lock lock (m_compiled_mutex);
+      auto replacement = m_named_units.find (replacement_name);
+      if (replacement == m_named_units.end ())
+        throw ir_exception ("`" + name + "` was released while it was being replaced.");
+
+      std::shared_ptr<compiled_unit> unit = replacement->second.unit;
+      try
+      {
+        if (auto old = m_named_units.find (name); old != m_named_units.end ())
+        {
+          if (old->second.unit->would_orphan (name))
+            throw_shared_symbol (name);
+          release_name (old, garbage);
+        }
+        insert_name (name, unit, addr, replacement_name);
+
+        // Only the symbol is kept, as the target of the alias.
+        m_named_units.erase (replacement);
+        unit->names.erase (std::remove (unit->names.begin (), unit->names.end (), replacement_name),
+                           unit->names.end ());
+        m_orphaned_symbols.insert (replacement_name);
+      }
+      catch (...)
+      {
+        error = std::current_exception ();
+        if (replacement = m_named_units.find (replacement_name);
+            replacement != m_named_units.end ())
+        {
+          release_name (replacement, garbage);
+        }
+      }
+    }
+
+    remove_unit (garbage);
+    if (error)
+      std::rethrow_exception (error);
+    return addr;
+  }
+
+  void *
+  octave_jit_compiler_llvm::
+  publish (ir_static_function&& func)
+  {
+    std::string name (func.get_name ());
+    std::size_t generation;
+    {
+      std::scoped_lock lock (m_compiled_mutex);
+
+      // The entry point takes the name of the function, so the name must not be taken already.
+      if (m_named_units.find (name) != m_named_units.end ())
+        throw ir_exception ("Cannot publish `" + name + "`, since it has been compiled.");
+
+      auto [it, inserted] = m_published.try_emplace (name, published_function { nullptr, 0, 0 });
+      generation = ++it->second.num_generations;
+    }
+
+    // Each version gets its own symbol, so it never collides with the one it replaces.
+    void *addr = compile (ir_static_function (std::move (func),
+                                              get_version_name (name, generation)));
+    auto target = static_cast<std::uint64_t> (reinterpret_cast<std::uintptr_t> (addr));
+
+    std::scoped_lock lock (m_compiled_mutex);
+    published_function& published = m_published.at (name);
+
+    std::string what = "Could not publish `" + name + "`";
+    if (! published.stub)
+    {
+      published.stub = reinterpret_cast<void *> (
+        throw_if_error (m_interface->create_redirect (name, target), what));
+      published.current = generation;
+    }
+    else if (published.current < generation)
+    {
+      // An older version which finishes compiling late does not replace a newer one.
+      throw_if_error (m_interface->update_redirect (name, target), what);
+      published.current = generation;
+    }
+    return published.stub;
+  }
+
+  bool
+  octave_jit_compiler_llvm::
+  redirect (std::string_view name, std::size_t generation)
+  {
+    std::scoped_lock lock (m_compiled_mutex);
+    auto published = m_published.find (std::string (name));
+    if (published == m_published.end () || ! published->second.stub)
+      return false;
+
+    auto version = m_named_units.find (get_version_name (name, generation));
+    if (version == m_named_units.end ())
+      return false;
+
+    auto target = static_cast<std::uint64_t> (
+      reinterpret_cast<std::uintptr_t> (version->second.address));
+
+    throw_if_error (m_interface->update_redirect (name, target),
+                    "Could not redirect `" + std::string (name) + "`");
+    published->second.current = generation;
+    return true;
+  }
+
+  void *
+  octave_jit_compiler_llvm::
+  find (std::string_view name) const
+  {
+    std::scoped_lock lock (m_compiled_mutex);
+    std::string key (name);
+
+    if (auto published = m_published.find (key);
+        published != m_published.end () && published->second.stub)
+    {
+      return published->second.stub;
+    }
+
+    if (auto named = m_named_units.find (key); named != m_named_units.end ())
+      return named->second.address;
+
+    return nullptr;
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  register_runtime_function (octave_jit_runtime_function func)
+  {
+    std::string name = func.name;
+    if (llvm::Error err = m_interface->add_runtime_function (std::move (func)))
+    {
+      throw ir_exception ("Could not register the runtime function `" + name + "`: "
+                          + llvm::toString (std::move (err)));
+    }
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  emit_object (const function_refs& funcs, std::string_view path)
+  {
+    std::string configuration_id;
+    llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> obj =
+      m_interface->compile_object (funcs, configuration_id);
+    if (! obj)
+      throw ir_exception ("Could not compile the object: " + llvm::toString (obj.takeError ()));
+
+    std::string manifest (manifest_header);
+    manifest.append ("\n").append (configuration_id).append ("\n");
+    std::for_each (funcs.begin (), funcs.end (), [&](nonnull_ptr<const ir_static_function> f) {
+      manifest.append (f->get_name ()).append ("\t").append (get_signature (*f)).append ("\n");
+    });
+
+    // The manifest is written last, since a loader starts from it.
+    write_file (std::string (path), (*obj)->getBuffer ());
+    write_file (get_manifest_path (path), manifest);
+  }
+
+  std::vector<octave_jit_aot_function>
+  octave_jit_compiler_llvm::
+  load_object (std::string_view path)
+  {
+    std::string manifest_path = get_manifest_path (path);
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> manifest =
+      llvm::MemoryBuffer::getFile (manifest_path, /* IsText */ true);
+    if (! manifest)
+    {
+      throw ir_exception ("Could not read `" + manifest_path + "`: "
+                          + manifest.getError ().message ());
+    }
+
+    llvm::SmallVector<llvm::StringRef, 16> lines;
+    (*manifest)->getBuffer ().split (lines, '\n', -1, false);
+    if (lines.size () < 2 || lines[0].rtrim () != manifest_header)
+      throw ir_exception ("`" + manifest_path + "` is not an octave-ir manifest.");
+
+    // Code compiled for another CPU or with other settings may not run correctly here.
+    if (std::string configuration_id = m_interface->get_configuration_id ();
+        lines[1].rtrim () != configuration_id)
+    {
+      throw ir_exception ("`" + std::string (path) + "` was compiled for `"
+                          + lines[1].rtrim ().str ()
+                          + "`, which does not match the current configuration `"
+                          + configuration_id + "`.");
+    }
+
+    std::vector<octave_jit_aot_function> ret;
+    std::vector<std::string_view>        names;
+    std::for_each (std::next (lines.begin (), 2), lines.end (), [&](llvm::StringRef line) {
+      auto [name, signature] = line.rtrim ().split ('\t');
+      if (name.empty () || signature.empty ())
+        throw ir_exception ("`" + manifest_path + "` is malformed.");
+      ret.push_back ({ name.str (), signature.str (), nullptr });
+    });
+    names.reserve (ret.size ());
+    std::transform (ret.begin (), ret.end (), std::back_inserter (names),
+                    [](const octave_jit_aot_function& f) { return std::string_view (f.name); });
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> obj =
+      llvm::MemoryBuffer::getFile (llvm::StringRef (path.data (), path.size ()));
+    if (! obj)
+    {
+      throw ir_exception ("Could not read `" + std::string (path) + "`: "
+                          + obj.getError ().message ());
+    }
+
+    // The object is linked as one unit, just as if it had been compiled in one batch.
+    auto unit = std::make_shared<compiled_unit> ();
+    unit->symbols.assign (names.begin (), names.end ());
+    llvm::orc::ResourceTrackerSP& tracker =
+      unit->trackers.emplace_back (m_interface->create_resource_tracker ());
+
+    try
+    {
+      if (llvm::Error err = m_interface->add_object (std::move (*obj), tracker))
+        throw ir_exception ("Could not load `" + std::string (path) + "`: "
+                            + llvm::toString (std::move (err)));
+
+      auto syms = m_interface->find_symbols (names);
+      if (! syms)
+        throw ir_exception ("Could not load `" + std::string (path) + "`: "
+                            + llvm::toString (syms.takeError ()));
+
+      for (std::size_t i = 0; i < ret.size (); ++i)
+      {
+        ret[i].address = reinterpret_cast<void *> ((*syms)[i].getAddress ());
+        register_name (ret[i].name, unit, ret[i].address, ret[i].name);
+      }
+    }
+    catch (...)
+    {
+      {
+        std::scoped_lock lock (m_compiled_mutex);
+        unregister_unit (unit);
+      }
+      remove_unit (*unit);
+      throw;
+    }
+    return ret;
+  }
+
+  octave_jit_memory_stats
+  octave_jit_compiler_llvm::
+  get_memory_stats (void) const
+  {
+    return m_interface->get_memory_stats ();
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  enable_statistics (bool enable)
+  {
+    m_interface->enable_statistics (enable);
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  reset_statistics (void)
+  {
+    m_interface->reset_statistics ();
+  }
+
+  octave_jit_compile_stats
+  octave_jit_compiler_llvm::
+  get_statistics (void) const
+  {
+    return m_interface->get_statistics ();
+  }
+
+  std::string
+  octave_jit_compiler_llvm::
+  get_chrome_trace (void) const
+  {
+    return m_interface->get_chrome_trace ();
+  }
+
+  void *
+  octave_jit_compiler_llvm::
+  find_or_compile (std::string_view name, const ir_static_fingerprint& fp,
+                   const std::function<void * (compiled_unit&)>& compile_new)
+  {
+    while (true)
+    {
+      std::promise<void *> promise;
+      auto unit = std::make_shared<compiled_unit> ();
+      {
+        std::unique_lock lock (m_compiled_mutex);
+        if (m_published.find (std::string (name)) != m_published.end ())
+        {
+          throw ir_exception ("Cannot compile `" + std::string (name)
+                              + "`, since it is published.");
+        }
+
+        if (m_compiled.find (fp) == m_compiled.end ())
+          check_symbol_available (name);
+
+        compiled_function compiled { promise.get_future ().share (), unit, std::string (name) };
+        auto [it, inserted] = m_compiled.try_emplace (fp, std::move (compiled));
+        if (! inserted)
+        {
+          compiled_function existing = it->second;
+          lock.unlock ();
+
+          void *addr = existing.address.get ();
+          if (register_name (name, existing.unit, addr, existing.symbol))
+            return addr;
+          continue;
+        }
+        unit->fingerprints.push_back (fp);
+        unit->symbols.emplace_back (name);
+      }
+
+      try
+      {
+        void *addr = compile_new (*unit);
+        register_name (name, unit, addr, name);
+        promise.set_value (addr);
+        return addr;
+      }
+      catch (...)
+      {
+        {
+          std::scoped_lock lock (m_compiled_mutex);
+          m_compiled.erase (fp);
+        }
+        // Waiters are released first, since the cleanup may fail as well.
+        promise.set_exception (std::current_exception ());
+        remove_unit (*unit);
+        throw;
+      }
+    }
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  check_jit_callees (const function_refs& funcs) const
+  {
+    std::scoped_lock lock (m_compiled_mutex);
+    auto is_known = [&](std::string_view name) {
+      if (std::any_of (funcs.begin (), funcs.end (), [&](nonnull_ptr<const ir_static_function> f) {
+            return f->get_name () == name;
+          }))
+      {
+        return true;
+      }
+
+      std::string key (name);
+      if (auto published = m_published.find (key);
+          published != m_published.end () && published->second.stub)
+      {
+        return true;
+      }
+      return m_named_units.find (key) != m_named_units.end ();
+    };
+
+    std::for_each (funcs.begin (), funcs.end (), [&](nonnull_ptr<const ir_static_function> f) {
+      for (const ir_static_block& block : *f)
+      {
+        for (const ir_static_instruction& instr : block)
+        {
+          if (! is_a<ir_opcode::call> (instr) || instr.empty ())
+            continue;
+
+          const auto& callee = as_constant<ir_external_function_info> (instr[0]);
+          if (callee.get_linkage () == ir_external_function_info::linkage::jit
+              &&  ! is_known (callee.get_name ()))
+          {
+            throw ir_exception ("`" + std::string (f->get_name ()) + "` calls `"
+                                + std::string (callee.get_name ())
+                                + "`, which has not been compiled.");
+          }
+        }
+      }
+    });
+  }
+
+  void *
+  octave_jit_compiler_llvm::
+  compile_entry (const ir_static_function& func, llvm_entry_kind kind)
+  {
+    // The entry name doubles as the fingerprint variant, since it differs by kind.
+    check_jit_callees ({ nonnull_ptr { func } });
+
+    std::string name = get_entry_name (func.get_name (), kind);
+    ir_static_fingerprint fp (func, get_entry_name ("", kind));
+    return find_or_compile (name, fp, [&](compiled_unit& unit) {
+      llvm::orc::ResourceTrackerSP& tracker =
+        unit.trackers.emplace_back (m_interface->create_resource_tracker ());
+
+      std::string what = "Could not compile `" + name + "`";
+      throw_if_error (m_interface->add_entry_ast (func, kind, tracker), what);
+      auto sym = throw_if_error (m_interface->find_symbol (name), what);
+      return reinterpret_cast<void *> (sym.getAddress ());
+    });
+  }
+
+  bool
+  octave_jit_compiler_llvm::
+  register_name (std::string_view name, const std::shared_ptr<compiled_unit>& unit,
+                 void *address, std::string_view symbol)
+  {
+    std::scoped_lock lock (m_compiled_mutex);
+    return insert_name (name, unit, address, symbol);
+  }
+
+  bool
+  octave_jit_compiler_llvm::
+  insert_name (std::string_view name, const std::shared_ptr<compiled_unit>& unit,
+               void *address, std::string_view symbol)
+  {
+    if (unit->released)
+      return false;
+
+    // A name whose symbol was orphaned may only refer to that same code again.
+    if (name != symbol)
+      check_symbol_available (name);
+
+    auto [it, inserted] = m_named_units.try_emplace (std::string (name),
+                                                     named_function { unit, address });
+    if (! inserted)
+    {
+      if (it->second.unit == unit)
+        return true;
+
+      throw ir_exception ("A different function named `" + std::string (name)
+                          + "` has already been compiled.");
+    }
+
+    // A function deduplicated against one compiled under another name needs a symbol of its
+    // own so that other compiled code can call it. The alias is freed along with the name.
+    if (name != symbol && unit->aliases.find (it->first) == unit->aliases.end ())
+    {
+      llvm::orc::ResourceTrackerSP tracker = m_interface->create_resource_tracker ();
+      if (llvm::Error err = m_interface->add_alias (name, symbol, tracker))
+      {
+        m_named_units.erase (it);
+        throw_if_error (std::move (err), "Could not define `" + std::string (name) + "`");
+      }
+      unit->aliases.emplace (name, std::move (tracker));
+    }
+
+    unit->names.emplace_back (name);
+    m_orphaned_symbols.erase (it->first);
+    return true;
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  release_name (std::unordered_map<std::string, named_function>::iterator it,
+                compiled_unit& garbage)
+  {
+    std::string                    name = it->first;
+    std::shared_ptr<compiled_unit> unit = it->second.unit;
+    m_named_units.erase (it);
+
+    unit->names.erase (std::remove (unit->names.begin (), unit->names.end (), name),
+                       unit->names.end ());
+    if (auto alias = unit->aliases.find (name); alias != unit->aliases.end ())
+    {
+      garbage.trackers.push_back (std::move (alias->second));
+      unit->aliases.erase (alias);
+    }
+
+    if (unit->names.empty ())
+    {
+      // The code is freed along with the last name which refers to it.
+      unregister_unit (unit);
+      std::for_each (unit->aliases.begin (), unit->aliases.end (), [&](auto& alias) {
+        garbage.trackers.push_back (std::move (alias.second));
+      });
+      std::move (unit->trackers.begin (), unit->trackers.end (),
+                 std::back_inserter (garbage.trackers));
+      unit->aliases.clear ();
+      unit->trackers.clear ();
+    }
+    else if (std::find (unit->symbols.begin (), unit->symbols.end (), name)
+             != unit->symbols.end ())
+    {
+      m_orphaned_symbols.insert (std::move (name));
+    }
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  check_symbol_available (std::string_view name) const
+  {
+    if (m_orphaned_symbols.find (std::string (name)) != m_orphaned_symbols.end ())
+      throw_shared_symbol (name);
+  }
+
+  bool
+  octave_jit_compiler_llvm::
+  is_current_version (std::string_view name) const
+  {
+    std::size_t pos = name.rfind ('#');
+    if (pos == std::string_view::npos)
+      return false;
+
+    auto published = m_published.find (std::string (name.substr (0, pos)));
+    return published != m_published.end ()
+       &&  published->second.stub
+       &&  get_version_name (published->first, published->second.current) == name;
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  unregister_unit (const std::shared_ptr<compiled_unit>& unit)
+  {
+    unit->released = true;
+
+    std::for_each (unit->fingerprints.begin (), unit->fingerprints.end (),
+                   [&](const ir_static_fingerprint& fp) {
+      if (auto it = m_compiled.find (fp); it != m_compiled.end () && it->second.unit == unit)
+        m_compiled.erase (it);
+    });
+
+    std::for_each (unit->names.begin (), unit->names.end (), [&](const std::string& n) {
+      auto it = m_named_units.find (n);
+      if (it != m_named_units.end () && it->second.unit == unit)
+        m_named_units.erase (it);
+    });
+
+    std::for_each (unit->symbols.begin (), unit->symbols.end (), [&](const std::string& sym) {
+      m_orphaned_symbols.erase (sym);
+    });
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  remove_unit (compiled_unit& unit)
+  {
+    // Every tracker is removed even if one of them fails. Aliases go before their targets.
+    llvm::Error err = llvm::Error::success ();
+    std::for_each (unit.aliases.begin (), unit.aliases.end (), [&](auto& alias) {
+      err = llvm::joinErrors (std::move (err), m_interface->remove (std::move (alias.second)));
+    });
+    std::for_each (unit.trackers.begin (), unit.trackers.end (),
+                   [&](llvm::orc::ResourceTrackerSP& tracker) {
+      err = llvm::joinErrors (std::move (err), m_interface->remove (std::move (tracker)));
+    });
+    unit.aliases.clear ();
+    unit.trackers.clear ();
+    throw_if_error (std::move (err), "Could not remove the compiled code");
   }
 
   void
@@ -39,4 +993,74 @@ namespace gch
     m_interface->enable_printing (printing);
   }
 
+  void
+  octave_jit_compiler_llvm::
+  set_optimization_level (octave_jit_optimization_level level)
+  {
+    m_interface->set_optimization_level (level);
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  append_passes (std::string_view pipeline)
+  {
+    m_interface->append_passes (pipeline);
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  clear_passes (void)
+  {
+    m_interface->clear_passes ();
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  set_target_cpu (std::string_view cpu, std::string_view features)
+  {
+    m_interface->set_target_cpu (cpu, features);
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  set_vector_library (octave_jit_vector_library lib)
+  {
+    m_interface->set_vector_library (lib);
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  enable_object_cache (std::string_view directory, std::size_t max_size)
+  {
+    m_interface->enable_object_cache (directory, max_size);
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  disable_object_cache (void)
+  {
+    m_interface->disable_object_cache ();
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  enable_jit_registration (void)
+  {
+    m_interface->enable_jit_registration ();
+  }
+
+  void
+  octave_jit_compiler_llvm::
+  enable_debug_info (bool enable)
+  {
+    m_interface->enable_debug_info (enable);
+  }
+
+  std::optional<octave_jit_source_location>
+  octave_jit_compiler_llvm::
+  find_source_location (const void *address) const
+  {
+    return m_interface->find_source_location (reinterpret_cast<std::uintptr_t> (address));
+  }
+
 }
@@ -27,6 +27,32 @@ namespace gch
     template <bool B>
     static constexpr variadic_type variadic { B };
 
+    // Where the callee is found.
+    enum class linkage
+    {
+      host, // A function in the host process.
+      jit,  // Another static function, compiled by the same compiler as the caller.
+    };
+
+    // What a host function is known to do, so that calls to it may be combined, hoisted out of
+    // loops, or deleted when unused. These are promises; breaking one is undefined behavior.
+    struct attributes
+    {
+      bool read_none   = false; // Neither reads nor writes memory other than its own stack.
+      bool read_only   = false; // Does not write memory other than its own stack.
+      bool no_unwind   = false; // Never throws.
+      bool will_return = false; // Always returns to the caller.
+      bool no_free     = false; // Does not free memory.
+
+      // A function whose result depends only on its arguments, such as a math function.
+      [[nodiscard]] static constexpr
+      attributes
+      pure (void) noexcept
+      {
+        return { true, false, true, true, true };
+      }
+    };
+
     ir_external_function_info            (void)                                 = delete;
     ir_external_function_info            (const ir_external_function_info&)     = default;
     ir_external_function_info            (ir_external_function_info&&) noexcept = default;
@@ -36,6 +62,10 @@ namespace gch
 
     ir_external_function_info (std::string_view name, variadic_type is_variadic);
     ir_external_function_info (std::string_view name);
+    ir_external_function_info (std::string_view name, linkage l);
+    ir_external_function_info (std::string_view name, attributes attrs);
+    ir_external_function_info (std::string_view name, variadic_type is_variadic,
+                               attributes attrs);
 
     [[nodiscard]]
     std::string_view
@@ -45,9 +75,19 @@ namespace gch
     bool
     is_variadic (void) const noexcept;
 
+    [[nodiscard]]
+    linkage
+    get_linkage (void) const noexcept;
+
+    [[nodiscard]]
+    const attributes&
+    get_attributes (void) const noexcept;
+
   private:
     std::string   m_name;
     variadic_type m_is_variadic = variadic<false>;
+    linkage       m_linkage     = linkage::host;
+    attributes    m_attributes;
   };
 
   std::ostream&
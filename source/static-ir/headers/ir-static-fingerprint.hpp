@@ -0,0 +1,81 @@
+/** ir-static-fingerprint.hpp
+ * A canonical, name-independent encoding of the structure of a static function.
+ *
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef OCTAVE_IR_STATIC_IR_IR_STATIC_FINGERPRINT_HPP
+#define OCTAVE_IR_STATIC_IR_IR_STATIC_FINGERPRINT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace gch
+{
+
+  class ir_static_function;
+
+  // Two static functions have equal fingerprints if and only if they have the same blocks,
+  // instructions, operands, constants, variable types, and signature. The names of the function,
+  // its blocks, and its variables are not included.
+  class ir_static_fingerprint
+  {
+  public:
+    ir_static_fingerprint            (void)                             = delete;
+    ir_static_fingerprint            (const ir_static_fingerprint&)     = default;
+    ir_static_fingerprint            (ir_static_fingerprint&&) noexcept = default;
+    ir_static_fingerprint& operator= (const ir_static_fingerprint&)     = default;
+    ir_static_fingerprint& operator= (ir_static_fingerprint&&) noexcept = default;
+    ~ir_static_fingerprint           (void)                             = default;
+
+    explicit
+    ir_static_fingerprint (const ir_static_function& func);
+
+    // Distinguishes different forms of code generated from the same function.
+    ir_static_fingerprint (const ir_static_function& func, std::string_view variant);
+
+    [[nodiscard]]
+    std::uint64_t
+    get_hash (void) const noexcept;
+
+    [[nodiscard]]
+    std::string_view
+    get_data (void) const noexcept;
+
+  private:
+    std::string   m_data;
+    std::uint64_t m_hash;
+  };
+
+  [[nodiscard]]
+  bool
+  operator== (const ir_static_fingerprint& lhs, const ir_static_fingerprint& rhs) noexcept;
+
+  [[nodiscard]]
+  bool
+  operator!= (const ir_static_fingerprint& lhs, const ir_static_fingerprint& rhs) noexcept;
+
+}
+
+namespace std
+{
+
+  template <>
+  struct hash<gch::ir_static_fingerprint>
+  {
+    std::size_t
+    operator() (const gch::ir_static_fingerprint& fp) const noexcept
+    {
+      return static_cast<std::size_t> (fp.get_hash ());
+    }
+  };
+
+}
+
+#endif // OCTAVE_IR_STATIC_IR_IR_STATIC_FINGERPRINT_HPP
@@ -105,6 +105,9 @@ namespace gch
                         small_vector<ir_variable_id>&& ret_ids,
                         small_vector<ir_variable_id>&& arg_ids);
 
+    // Takes over the function under a different name.
+    ir_static_function (ir_static_function&& other, std::string_view name);
+
     [[nodiscard]]
     const_iterator
     begin (void) const noexcept;
@@ -23,6 +23,26 @@ namespace gch
     : m_name (name)
   { }
 
+  ir_external_function_info::
+  ir_external_function_info (std::string_view name, linkage l)
+    : m_name    (name),
+      m_linkage (l)
+  { }
+
+  ir_external_function_info::
+  ir_external_function_info (std::string_view name, attributes attrs)
+    : m_name       (name),
+      m_attributes (attrs)
+  { }
+
+  ir_external_function_info::
+  ir_external_function_info (std::string_view name, variadic_type is_variadic,
+                             attributes attrs)
+    : m_name        (name),
+      m_is_variadic (is_variadic),
+      m_attributes  (attrs)
+  { }
+
   std::string_view
   ir_external_function_info::
   get_name (void) const noexcept
@@ -37,13 +57,44 @@ namespace gch
     return m_is_variadic;
   }
 
+  auto
+  ir_external_function_info::
+  get_linkage (void) const noexcept
+    -> linkage
+  {
+    return m_linkage;
+  }
+
+  auto
+  ir_external_function_info::
+  get_attributes (void) const noexcept
+    -> const attributes&
+  {
+    return m_attributes;
+  }
+
   std::ostream&
   operator<< (std::ostream& out, const ir_external_function_info& info)
   {
+    if (info.get_linkage () == ir_external_function_info::linkage::jit)
+      out << "jit ";
     out << info.get_name () << " (";
     if (info.is_variadic ())
       out << "...";
-    return out << ")";
+    out << ")";
+
+    const ir_external_function_info::attributes& attrs = info.get_attributes ();
+    if (attrs.read_none)
+      out << " readnone";
+    if (attrs.read_only)
+      out << " readonly";
+    if (attrs.no_unwind)
+      out << " nounwind";
+    if (attrs.will_return)
+      out << " willreturn";
+    if (attrs.no_free)
+      out << " nofree";
+    return out;
   }
 
 }
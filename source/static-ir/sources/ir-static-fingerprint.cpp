@@ -0,0 +1,287 @@
+/** ir-static-fingerprint.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "ir-static-fingerprint.hpp"
+
+#include "ir-static-function.hpp"
+#include "ir-static-block.hpp"
+#include "ir-static-instruction.hpp"
+#include "ir-static-operand.hpp"
+#include "ir-static-variable.hpp"
+#include "ir-type-util.hpp"
+
+#include <algorithm>
+#include <complex>
+#include <ios>
+#include <iterator>
+#include <sstream>
+#include <type_traits>
+
+namespace gch
+{
+
+  namespace
+  {
+
+    void
+    append_integer (std::string& data, std::uint64_t val)
+    {
+      for (unsigned i = 0; i < 8; ++i)
+        data.push_back (static_cast<char> ((val >> (8 * i)) & 0xFF));
+    }
+
+    void
+    append_string (std::string& data, std::string_view str)
+    {
+      append_integer (data, str.size ());
+      data.append (str);
+    }
+
+    // Floating point values are encoded textually so that padding bits (as in x87 long doubles)
+    // do not leak into the fingerprint.
+    template <typename T>
+    void
+    append_floating_point (std::string& data, T val)
+    {
+      std::ostringstream out;
+      out << std::hexfloat << val;
+      append_string (data, out.str ());
+    }
+
+    template <typename T>
+    struct constant_encoder
+    {
+      static
+      void
+      encode (std::string& data, const ir_constant& c)
+      {
+        const auto& val = as<T> (c);
+        if constexpr (std::is_floating_point_v<T>)
+          append_floating_point (data, val);
+        else
+          append_integer (data, static_cast<std::uint64_t> (val));
+      }
+    };
+
+    template <typename T>
+    struct constant_encoder<std::complex<T>>
+    {
+      static
+      void
+      encode (std::string& data, const ir_constant& c)
+      {
+        const auto& val = as<std::complex<T>> (c);
+        append_floating_point (data, val.real ());
+        append_floating_point (data, val.imag ());
+      }
+    };
+
+    // Pointers to narrow characters are emitted as string literals, so their contents matter
+    // rather than their addresses.
+    template <typename T>
+    struct constant_encoder<T *>
+    {
+      static
+      void
+      encode (std::string& data, const ir_constant& c)
+      {
+        const auto& val = as<T *> (c);
+        if constexpr (std::is_same_v<T, char>)
+          append_string (data, val ? std::string_view (val) : std::string_view ());
+        else
+          append_integer (data, reinterpret_cast<std::uintptr_t> (val));
+      }
+    };
+
+    template <>
+    struct constant_encoder<void>
+    {
+      static
+      void
+      encode (std::string&, const ir_constant&)
+      { }
+    };
+
+    template <>
+    struct constant_encoder<std::string>
+    {
+      static
+      void
+      encode (std::string& data, const ir_constant& c)
+      {
+        append_string (data, as<std::string> (c));
+      }
+    };
+
+    template <>
+    struct constant_encoder<ir_block_id>
+    {
+      static
+      void
+      encode (std::string& data, const ir_constant& c)
+      {
+        append_integer (data, static_cast<std::size_t> (as<ir_block_id> (c)));
+      }
+    };
+
+    template <>
+    struct constant_encoder<ir_external_function_info>
+    {
+      static
+      void
+      encode (std::string& data, const ir_constant& c)
+      {
+        const auto& info = as<ir_external_function_info> (c);
+        append_string (data, info.get_name ());
+        append_integer (data, info.is_variadic ());
+        append_integer (data, static_cast<std::uint64_t> (info.get_linkage ()));
+
+        const ir_external_function_info::attributes& attrs = info.get_attributes ();
+        append_integer (data, attrs.read_none);
+        append_integer (data, attrs.read_only);
+        append_integer (data, attrs.no_unwind);
+        append_integer (data, attrs.will_return);
+        append_integer (data, attrs.no_free);
+      }
+    };
+
+    template <typename T>
+    struct encoder_mapper
+    {
+      constexpr
+      auto
+      operator() (void) const noexcept
+      {
+        return constant_encoder<T>::encode;
+      }
+    };
+
+    void
+    append_constant (std::string& data, const ir_constant& c)
+    {
+      constexpr auto map = generate_ir_type_map<encoder_mapper> ();
+      append_integer (data, c.get_type ().get_index ());
+      map[c.get_type ()] (data, c);
+    }
+
+    void
+    append_operand (std::string& data, const ir_static_operand& op)
+    {
+      if (optional_ref c { maybe_as_constant (op) })
+      {
+        append_integer (data, 0);
+        append_constant (data, *c);
+        return;
+      }
+
+      ir_static_use use = as_use (op);
+      append_integer (data, 1);
+      append_integer (data, static_cast<std::size_t> (use.get_variable_id ()));
+      append_integer (data, use.has_def_id ());
+      if (use.has_def_id ())
+        append_integer (data, static_cast<std::size_t> (use.get_def_id ()));
+    }
+
+    void
+    append_instruction (std::string& data, const ir_static_instruction& instr)
+    {
+      append_integer (data, instr.get_metadata ().get_index ());
+
+      append_integer (data, instr.has_def ());
+      if (instr.has_def ())
+      {
+        append_integer (data, static_cast<std::size_t> (instr.get_def ().get_variable_id ()));
+        append_integer (data, static_cast<std::size_t> (instr.get_def ().get_id ()));
+      }
+
+      append_integer (data, instr.num_args ());
+      for (const ir_static_operand& op : instr)
+        append_operand (data, op);
+    }
+
+    std::uint64_t
+    fnv1a (std::string_view data) noexcept
+    {
+      std::uint64_t hash = 0xCBF29CE484222325ULL;
+      for (char c : data)
+      {
+        hash ^= static_cast<unsigned char> (c);
+        hash *= 0x100000001B3ULL;
+      }
+      return hash;
+    }
+
+  }
+
+  ir_static_fingerprint::
+  ir_static_fingerprint (const ir_static_function& func)
+  {
+    append_integer (m_data, static_cast<std::uint64_t> (
+      std::distance (func.variables_begin (), func.variables_end ())));
+    std::for_each (func.variables_begin (), func.variables_end (),
+                   [&](const ir_static_variable& var) {
+      append_integer (m_data, var.get_type ().get_index ());
+    });
+
+    append_integer (m_data, static_cast<std::uint64_t> (
+      std::distance (func.args_begin (), func.args_end ())));
+    std::for_each (func.args_begin (), func.args_end (), [&](ir_variable_id id) {
+      append_integer (m_data, static_cast<std::size_t> (id));
+    });
+
+    append_integer (m_data, static_cast<std::uint64_t> (
+      std::distance (func.returns_begin (), func.returns_end ())));
+    std::for_each (func.returns_begin (), func.returns_end (), [&](ir_variable_id id) {
+      append_integer (m_data, static_cast<std::size_t> (id));
+    });
+
+    append_integer (m_data, func.num_blocks ());
+    for (const ir_static_block& block : func)
+    {
+      append_integer (m_data, block.size ());
+      for (const ir_static_instruction& instr : block)
+        append_instruction (m_data, instr);
+    }
+
+    m_hash = fnv1a (m_data);
+  }
+
+  ir_static_fingerprint::
+  ir_static_fingerprint (const ir_static_function& func, std::string_view variant)
+    : ir_static_fingerprint (func)
+  {
+    append_string (m_data, variant);
+    m_hash = fnv1a (m_data);
+  }
+
+  std::uint64_t
+  ir_static_fingerprint::
+  get_hash (void) const noexcept
+  {
+    return m_hash;
+  }
+
+  std::string_view
+  ir_static_fingerprint::
+  get_data (void) const noexcept
+  {
+    return m_data;
+  }
+
+  bool
+  operator== (const ir_static_fingerprint& lhs, const ir_static_fingerprint& rhs) noexcept
+  {
+    return lhs.get_hash () == rhs.get_hash () && lhs.get_data () == rhs.get_data ();
+  }
+
+  bool
+  operator!= (const ir_static_fingerprint& lhs, const ir_static_fingerprint& rhs) noexcept
+  {
+    return ! (lhs == rhs);
+  }
+
+}
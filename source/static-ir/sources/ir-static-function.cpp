@@ -13,6 +13,7 @@
 
 #include <numeric>
 #include <ostream>
+#include <utility>
 
 namespace gch
 {
@@ -30,6 +31,13 @@ namespace gch
       m_arg_ids   (std::move (arg_ids))
   { }
 
+  ir_static_function::
+  ir_static_function (ir_static_function&& other, std::string_view name)
+    : ir_static_function (std::move (other))
+  {
+    m_name = name;
+  }
+
   ir_static_function::~ir_static_function (void) = default;
 
   auto
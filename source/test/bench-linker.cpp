@@ -0,0 +1,192 @@
+/** bench-linker.cpp
+ * Compares the link time and memory footprint of the JIT linkers.
+ *
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#  include <unistd.h>
+#endif
+
+using namespace gch;
+
+// The same kinds of functions as the tests compile: straight-line arithmetic (see
+// `create_add_constant_function`), and a loop.
+
+static
+ir_static_function
+create_loop_function (std::string_view name, int c)
+{
+  ir_function my_func ({ "x", ir_type_v<int> }, name);
+
+  ir_variable& var_x = my_func.get_variable ("x");
+  ir_variable& var_i = my_func.create_variable<int> ("i");
+  my_func.set_anonymous_variable_type<bool> ();
+
+  auto& seq = dynamic_cast<ir_component_sequence&> (my_func.get_body ());
+
+  ir_block& entry_block     = get_entry_block (seq);
+  auto&     loop            = seq.emplace_back<ir_component_loop> (my_func.get_variable ());
+  auto&     start_block     = static_cast<ir_block&> (loop.get_start ());
+  ir_block& condition_block = loop.get_condition ();
+  auto&     body_seq        = static_cast<ir_component_sequence&> (loop.get_body ());
+  auto&     body_block      = static_cast<ir_block&> (body_seq.front ());
+  auto&     update_block    = static_cast<ir_block&> (loop.get_update ());
+  seq.emplace_back<ir_block> ();
+
+  entry_block    .append_with_def<ir_opcode::assign> (var_x, 1);
+  start_block    .append_with_def<ir_opcode::assign> (var_i, 0);
+  update_block   .append_with_def<ir_opcode::add>    (var_i, var_i, 1);
+  body_block     .append_with_def<ir_opcode::add>    (var_x, var_x, c);
+  condition_block.append_with_def<ir_opcode::lt>     (condition_block.get_condition_variable (), var_i, 5);
+
+  return generate_static_function (my_func);
+}
+
+// Returns the resident set size in bytes, or zero where it is unavailable.
+static
+std::size_t
+get_resident_size (void)
+{
+#ifdef __linux__
+  std::ifstream statm ("/proc/self/statm");
+  std::size_t size     = 0;
+  std::size_t resident = 0;
+  if (! (statm >> size >> resident))
+    return 0;
+  return resident * static_cast<std::size_t> (sysconf (_SC_PAGESIZE));
+#else
+  return 0;
+#endif
+}
+
+struct bench_result
+{
+  double      cold_ms;
+  double      link_ms;
+  std::size_t resident_delta;
+  std::size_t allocated;      // Pages handed out to objects, of every section kind.
+  std::size_t used;           // Bytes of those pages occupied by sections.
+};
+
+static
+std::size_t
+get_total (const octave_jit_memory_stats& stats, std::size_t octave_jit_memory_usage::* field)
+{
+  return stats.code.*field + stats.rodata.*field + stats.data.*field;
+}
+
+static
+double
+compile_all (octave_jit_compiler& jit, const std::vector<ir_static_function>& funcs)
+{
+  auto start = std::chrono::steady_clock::now ();
+  std::for_each (funcs.begin (), funcs.end (), [&](const ir_static_function& func) {
+    if (jit.compile (func) == nullptr)
+      throw std::runtime_error ("Compilation failed.");
+  });
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now () - start;
+  return elapsed.count ();
+}
+
+static
+bench_result
+run (octave_jit_llvm_linker linker, const std::vector<ir_static_function>& funcs)
+{
+  namespace fs = std::filesystem;
+
+  fs::path cache_dir = fs::temp_directory_path ()
+                     / ("octave-ir-bench-linker-" + std::to_string (static_cast<int> (linker)));
+  fs::remove_all (cache_dir);
+
+  bench_result result { };
+
+  // The first compiler populates the object cache, so this includes codegen.
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> (linker);
+    jit.enable_object_cache (cache_dir.string ());
+    result.cold_ms = compile_all (jit, funcs);
+  }
+
+  // Every object is loaded from the cache, so this is almost entirely linking.
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> (linker);
+    jit.enable_object_cache (cache_dir.string ());
+
+    std::size_t resident_before = get_resident_size ();
+    result.link_ms = compile_all (jit, funcs);
+    std::size_t resident_after = get_resident_size ();
+
+    if (resident_before < resident_after)
+      result.resident_delta = resident_after - resident_before;
+
+    // Objects do not share pages, so most of what small functions allocate is padding. Only
+    // the rtdyld memory manager reports these.
+    octave_jit_memory_stats stats = jit.get_memory_stats ();
+    result.allocated = get_total (stats, &octave_jit_memory_usage::allocated);
+    result.used      = get_total (stats, &octave_jit_memory_usage::used);
+  }
+
+  fs::remove_all (cache_dir);
+  return result;
+}
+
+int
+main (int argc, char **argv)
+{
+  try
+  {
+    int num_funcs = (1 < argc) ? std::stoi (argv[1]) : 500;
+
+    std::vector<ir_static_function> funcs;
+    funcs.reserve (static_cast<std::size_t> (num_funcs) * 2);
+    for (int i = 0; i < num_funcs; ++i)
+    {
+      funcs.push_back (create_add_constant_function ("binary" + std::to_string (i), i));
+      funcs.push_back (create_loop_function ("loop" + std::to_string (i), i));
+    }
+
+    std::cout << std::left
+              << std::setw (10) << "linker"
+              << std::setw (14) << "cold (ms)"
+              << std::setw (14) << "link (ms)"
+              << std::setw (18) << "RSS delta (KiB)"
+              << "allocated/used (KiB)" << std::endl;
+
+    for (auto [linker, name] : { std::pair { octave_jit_llvm_linker::rtdyld,  "rtdyld" },
+                                 std::pair { octave_jit_llvm_linker::jitlink, "jitlink" } })
+    {
+      bench_result result = run (linker, funcs);
+      std::cout << std::setw (10) << name
+                << std::setw (14) << result.cold_ms
+                << std::setw (14) << result.link_ms
+                << std::setw (18) << result.resident_delta / 1024;
+
+      if (result.allocated == 0)
+        std::cout << "n/a" << std::endl;
+      else
+        std::cout << result.allocated / 1024 << '/' << result.used / 1024 << std::endl;
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
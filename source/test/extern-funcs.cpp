@@ -5,12 +5,8 @@
  * of the MIT license. See the LICENSE file for details.
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-#include "jit-exception.hpp"
-
-#include <csetjmp>
 #include <cstdio>
-#include <iostream>
-#include <memory>
+#include <stdexcept>
 
 #ifdef _WIN32
 #  define DLLEXPORT __declspec(dllexport)
@@ -18,9 +14,6 @@
 #  define DLLEXPORT
 #endif
 
-std::jmp_buf env_buffer;
-std::unique_ptr<std::exception> current_exception;
-
 extern "C" DLLEXPORT
 void
 print_error (const char *s);
@@ -40,14 +33,6 @@ extern "C"
 void
 throw_error (const char *s)
 {
-  try
-  {
-    current_exception = std::make_unique<std::runtime_error> (s);
-  }
-  catch (...)
-  {
-    // Ensure that this is reset.
-    current_exception.reset ();
-  }
-  std::longjmp (env_buffer, 1);
+  // Compiled functions have unwind tables, so this propagates to the caller of the JIT code.
+  throw std::runtime_error (s);
 }
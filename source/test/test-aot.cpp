@@ -0,0 +1,109 @@
+/** test-aot.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+#include <filesystem>
+
+using namespace gch;
+
+int
+main (void)
+{
+  namespace fs = std::filesystem;
+
+  fs::path obj_path = fs::temp_directory_path () / "octave-ir-test-aot.o";
+
+  try
+  {
+    {
+      auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+
+      ir_static_function add1 = create_add_constant_function ("aot_add1", 1);
+      ir_static_function add2 = create_add_constant_function ("aot_add2", 2);
+      jit.emit_object ({ nonnull_ptr { add1 }, nonnull_ptr { add2 } }, obj_path.string ());
+
+      // Emitting does not add anything to the compiler.
+      if (jit.find ("aot_add1"))
+        throw std::runtime_error ("Emitting an object should not compile its functions.");
+    }
+
+    if (! fs::exists (obj_path) || ! fs::exists (obj_path.string () + ".manifest"))
+      throw std::runtime_error ("The object and manifest were not written.");
+
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+    std::vector<octave_jit_aot_function> funcs = jit.load_object (obj_path.string ());
+
+    if (funcs.size () != 2 || funcs[0].name != "aot_add1" || funcs[1].name != "aot_add2")
+      throw std::runtime_error ("The manifest does not list the emitted functions.");
+
+    if (funcs[0].signature != "int (int)")
+      throw std::runtime_error ("Unexpected signature `" + funcs[0].signature + "`.");
+
+    if (invoke_compiled_function<int> (funcs[0].address, 1) != 2
+        ||  invoke_compiled_function<int> (funcs[1].address, 1) != 3)
+    {
+      throw std::runtime_error ("Incorrect result from a loaded function.");
+    }
+
+    if (jit.find ("aot_add2") != funcs[1].address)
+      throw std::runtime_error ("Loaded functions should be registered with the compiler.");
+
+    // The functions were linked together, so the object is kept until both are released.
+    if (! jit.release ("aot_add1") || jit.find ("aot_add1"))
+      throw std::runtime_error ("Failed to release a loaded function.");
+
+    if (invoke_compiled_function<int> (funcs[1].address, 1) != 3)
+      throw std::runtime_error ("Releasing one function should keep the rest of the object.");
+
+    if (! jit.release ("aot_add2") || jit.find ("aot_add2"))
+      throw std::runtime_error ("Failed to release the loaded object.");
+
+    bool threw = false;
+    try
+    {
+      jit.load_object ((fs::temp_directory_path () / "octave-ir-test-aot-missing.o").string ());
+    }
+    catch (const ir_exception&)
+    {
+      threw = true;
+    }
+
+    if (! threw)
+      throw std::runtime_error ("Loading a missing object should throw.");
+
+    // The object was compiled for the default settings, so it may not be loaded with others.
+    auto other_jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+    other_jit.set_optimization_level (octave_jit_optimization_level::O0);
+
+    threw = false;
+    try
+    {
+      other_jit.load_object (obj_path.string ());
+    }
+    catch (const ir_exception&)
+    {
+      threw = true;
+    }
+
+    if (! threw)
+      throw std::runtime_error ("Loading an object compiled with other settings should throw.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    fs::remove (obj_path);
+    fs::remove (obj_path.string () + ".manifest");
+    return 1;
+  }
+
+  fs::remove (obj_path);
+  fs::remove (obj_path.string () + ".manifest");
+
+  std::cout << "OK: aot" << std::endl;
+  return 0;
+}
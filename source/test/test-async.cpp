@@ -0,0 +1,139 @@
+/** test-async.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+#include "llvm-compile-queue.hpp"
+
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace gch;
+
+// A single worker held on a gate makes the order of the queued jobs deterministic.
+static
+void
+test_queue_order (void)
+{
+  auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+
+  std::promise<void>       started;
+  std::promise<void>       gate;
+  std::shared_future<void> gate_future = gate.get_future ().share ();
+
+  std::mutex               order_mutex;
+  std::vector<std::string> order;
+
+  llvm_compile_queue queue ([&](const ir_static_function& f) {
+    {
+      std::scoped_lock lock (order_mutex);
+      order.emplace_back (f.get_name ());
+    }
+
+    if (f.get_name () == "blocker")
+    {
+      started.set_value ();
+      gate_future.wait ();
+    }
+    return jit.compile (f);
+  }, 1, 8);
+
+  auto blocker = queue.submit (create_add_constant_function ("blocker", 0), 0);
+  started.get_future ().wait ();
+
+  // The worker is busy, so these all wait in the queue.
+  auto low       = queue.submit (create_add_constant_function ("low", 1), 0);
+  auto high      = queue.submit (create_add_constant_function ("high", 2), 2);
+  auto mid       = queue.submit (create_add_constant_function ("mid", 3), 1);
+  auto cancelled = queue.submit (create_add_constant_function ("cancelled", 4), 3);
+
+  if (blocker.cancel ())
+    throw std::runtime_error ("A running job should not be cancellable.");
+
+  if (! cancelled.cancel ())
+    throw std::runtime_error ("A queued job should be cancellable.");
+
+  gate.set_value ();
+
+  if (invoke_compiled_function<int> (low.get (), 10) != 11)
+    throw std::runtime_error ("Incorrect result for `low`.");
+  if (invoke_compiled_function<int> (high.get (), 10) != 12)
+    throw std::runtime_error ("Incorrect result for `high`.");
+  if (invoke_compiled_function<int> (mid.get (), 10) != 13)
+    throw std::runtime_error ("Incorrect result for `mid`.");
+
+  if (cancelled.get_status () != octave_jit_compile_handle::status::cancelled)
+    throw std::runtime_error ("A cancelled job should report that it was cancelled.");
+
+  try
+  {
+    static_cast<void> (cancelled.get ());
+    throw std::runtime_error ("Getting a cancelled job should throw.");
+  }
+  catch (const ir_exception&)
+  { }
+
+  // `low` was compiled last, so every job which was going to run has been recorded.
+  std::scoped_lock lock (order_mutex);
+  if (order != std::vector<std::string> { "blocker", "high", "mid", "low" })
+    throw std::runtime_error ("Queued jobs should start in order of priority.");
+}
+
+int
+main (void)
+{
+  constexpr int num_functions = 32;
+
+  try
+  {
+    test_queue_order ();
+
+    // A small queue makes submission exercise the capacity bound.
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> (4, 8);
+
+    std::vector<octave_jit_compile_handle> handles;
+    for (int i = 0; i < num_functions; ++i)
+    {
+      handles.push_back (
+        jit.compile_async (create_add_constant_function ("add_" + std::to_string (i), i), i % 3));
+    }
+
+    // Whether or not this succeeds depends on timing, but the handle must agree with it.
+    bool cancelled = handles.back ().cancel ();
+
+    for (int i = 0; i < num_functions; ++i)
+    {
+      if (i == num_functions - 1 && cancelled)
+      {
+        if (handles[i].get_status () != octave_jit_compile_handle::status::cancelled)
+          throw std::runtime_error ("A cancelled job should report that it was cancelled.");
+
+        try
+        {
+          static_cast<void> (handles[i].get ());
+          throw std::runtime_error ("Getting a cancelled job should throw.");
+        }
+        catch (const ir_exception&)
+        { }
+
+        continue;
+      }
+
+      if (invoke_compiled_function<int> (handles[i].get (), 10) != 10 + i)
+        throw std::runtime_error ("Incorrect result for `add_" + std::to_string (i) + "`.");
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: async" << std::endl;
+  return 0;
+}
@@ -0,0 +1,60 @@
+/** test-batch.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace gch;
+
+int
+main (void)
+{
+  constexpr int num_functions = 16;
+
+  try
+  {
+    std::vector<ir_static_function> funcs;
+    for (int i = 0; i < num_functions; ++i)
+      funcs.push_back (create_add_constant_function ("add_" + std::to_string (i), i));
+
+    // A structural duplicate of `add_3` under another name.
+    funcs.push_back (create_add_constant_function ("add_3_again", 3));
+
+    octave_jit_compiler::function_refs refs;
+    for (const ir_static_function& f : funcs)
+      refs.push_back (nonnull_ptr { f });
+
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+    std::vector<void *> addrs = jit.compile_batch (refs);
+
+    if (addrs.size () != refs.size ())
+      throw std::runtime_error ("Expected one entry point per function.");
+
+    for (int i = 0; i < num_functions; ++i)
+    {
+      if (invoke_compiled_function<int> (addrs[i], 100) != 100 + i)
+        throw std::runtime_error ("Incorrect result for `add_" + std::to_string (i) + "`.");
+    }
+
+    if (addrs.back () != addrs[3])
+      throw std::runtime_error ("Duplicates within a batch should share an entry point.");
+
+    // Functions compiled in a batch are visible to later compilations.
+    if (jit.compile (funcs[5]) != addrs[5])
+      throw std::runtime_error ("A batched function should not be compiled again.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: batch" << std::endl;
+  return 0;
+}
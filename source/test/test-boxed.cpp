@@ -0,0 +1,50 @@
+/** test-boxed.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+using namespace gch;
+
+int
+main (void)
+{
+  try
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+
+    // Functions of different types are called through the same signature.
+    octave_jit_boxed_function add_int    = jit.compile_boxed (create_add_function<int> ("addi"));
+    octave_jit_boxed_function add_double = jit.compile_boxed (create_add_function<double> ("addd"));
+
+    int   ix = 3;
+    int   iy = 4;
+    int   iz = 0;
+    void *iargs[] { &ix, &iy };
+    add_int (iargs, &iz);
+    if (iz != 7)
+      throw std::runtime_error ("Incorrect result from the boxed int function.");
+
+    double dx = 1.5;
+    double dy = 2.25;
+    double dz = 0.0;
+    void  *dargs[] { &dx, &dy };
+    add_double (dargs, &dz);
+    if (dz != 3.75)
+      throw std::runtime_error ("Incorrect result from the boxed double function.");
+
+    if (! jit.release ("addi.boxed"))
+      throw std::runtime_error ("The boxed entry point could not be released.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: boxed" << std::endl;
+  return 0;
+}
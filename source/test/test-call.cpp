@@ -16,12 +16,22 @@ main (void)
 
   ir_block& block = get_entry_block (my_func);
 
+  // Calls to a variadic function with different arguments share one declaration.
+  ir_external_function_info fprintf_info { "fprintf", ir_external_function_info::variadic<true> };
+
   block.append<ir_opcode::call> (
-    ir_external_function_info { "fprintf" },
+    fprintf_info,
     static_cast<void*> (stderr),
     "%s\n",
     "myerror");
 
+  block.append<ir_opcode::call> (
+    fprintf_info,
+    static_cast<void*> (stderr),
+    "%s %d\n",
+    "myerror",
+    2);
+
   block.append<ir_opcode::call> (
     ir_external_function_info { "fflush" },
     static_cast<void*> (stderr));
@@ -36,6 +46,21 @@ main (void)
   try
   {
     invoke_compiled_function (jit.compile (my_static_func));
+
+    // A fixed function can only be declared once per module.
+    ir_function conflicting_func ("conflicting");
+    ir_block& conflicting_block = get_entry_block (conflicting_func);
+    conflicting_block.append<ir_opcode::call> (ir_external_function_info { "fflush" },
+                                               static_cast<void*> (stderr));
+    conflicting_block.append<ir_opcode::call> (ir_external_function_info { "fflush" });
+
+    try
+    {
+      jit.compile (generate_static_function (conflicting_func));
+      throw std::runtime_error ("Calls with conflicting signatures should throw.");
+    }
+    catch (const ir_exception&)
+    { }
   }
   catch (const std::exception& e)
   {
@@ -0,0 +1,81 @@
+/** test-compile-stats.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+using namespace gch;
+
+static
+const octave_jit_phase_stats&
+get_phase (const octave_jit_compile_stats& stats, octave_jit_compile_phase phase)
+{
+  return stats.phases[static_cast<std::size_t> (phase)];
+}
+
+int
+main (void)
+{
+  try
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+
+    // Nothing is recorded until statistics are enabled.
+    jit.compile (create_add_constant_function ("f", 1));
+    if (! jit.get_statistics ().modules.empty ())
+      throw std::runtime_error ("Statistics should be disabled by default.");
+
+    // The body differs from `f`, so it is not deduplicated against it.
+    jit.enable_statistics ();
+    void *addr = jit.compile (create_add_constant_function ("g", 2));
+    if (invoke_compiled_function<int> (addr, 1) != 3)
+      throw std::runtime_error ("Incorrect result.");
+
+    octave_jit_compile_stats stats = jit.get_statistics ();
+    if (stats.modules.size () != 1)
+      throw std::runtime_error ("Expected one module.");
+
+    const octave_jit_module_stats& mod = stats.modules.front ();
+    if (mod.functions.size () != 1 || mod.functions.front () != "g")
+      throw std::runtime_error ("The module should list the compiled function.");
+
+    if (mod.num_blocks == 0 || mod.num_instructions == 0)
+      throw std::runtime_error ("Blocks and instructions should have been counted.");
+
+    if (mod.code_size == 0)
+      throw std::runtime_error ("Code size should have been recorded.");
+
+    for (octave_jit_compile_phase phase : { octave_jit_compile_phase::translate,
+                                            octave_jit_compile_phase::optimize,
+                                            octave_jit_compile_phase::codegen,
+                                            octave_jit_compile_phase::link })
+    {
+      if (get_phase (stats, phase).count != 1)
+        throw std::runtime_error ("Each phase should have run once.");
+    }
+
+    std::string trace = jit.get_chrome_trace ();
+    if (trace.empty () || trace.front () != '['
+        ||  trace.find ("\"codegen\"") == std::string::npos
+        ||  trace.find ("\"g\"") == std::string::npos)
+    {
+      throw std::runtime_error ("Unexpected trace:\n" + trace);
+    }
+
+    jit.reset_statistics ();
+    stats = jit.get_statistics ();
+    if (! stats.modules.empty () || get_phase (stats, octave_jit_compile_phase::codegen).count != 0)
+      throw std::runtime_error ("Statistics should have been reset.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: compile stats" << std::endl;
+  return 0;
+}
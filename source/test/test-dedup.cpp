@@ -0,0 +1,58 @@
+/** test-dedup.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+#include "ir-static-fingerprint.hpp"
+
+using namespace gch;
+
+int
+main (void)
+{
+  try
+  {
+    ir_static_function f = create_add_constant_function ("f", 1);
+    ir_static_function g = create_add_constant_function ("g", 1);
+    ir_static_function h = create_add_constant_function ("h", 2);
+
+    if (ir_static_fingerprint (f) != ir_static_fingerprint (g))
+      throw std::runtime_error ("Fingerprints should not depend on the function name.");
+
+    if (ir_static_fingerprint (f) == ir_static_fingerprint (h))
+      throw std::runtime_error ("Fingerprints should depend on constant operands.");
+
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+
+    void *f_addr = jit.compile (f);
+
+    // Recompiling the same function would otherwise collide in the JIT dylib.
+    if (jit.compile (f) != f_addr)
+      throw std::runtime_error ("Recompiling a function should return the same address.");
+
+    if (jit.compile (g) != f_addr)
+      throw std::runtime_error ("Identical bodies should share an entry point.");
+
+    void *h_addr = jit.compile (h);
+    if (h_addr == f_addr)
+      throw std::runtime_error ("Distinct bodies should not share an entry point.");
+
+    if (invoke_compiled_function<int> (f_addr, 4) != 5)
+      throw std::runtime_error ("Incorrect result for `f`.");
+
+    if (invoke_compiled_function<int> (h_addr, 4) != 6)
+      throw std::runtime_error ("Incorrect result for `h`.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: dedup" << std::endl;
+  return 0;
+}
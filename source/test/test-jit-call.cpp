@@ -0,0 +1,130 @@
+/** test-jit-call.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+#include <vector>
+
+using namespace gch;
+
+// Computes `2 * callee (x)`, where `callee` is another compiled function.
+static
+ir_static_function
+create_caller_function (std::string_view name, std::string_view callee)
+{
+  ir_function my_func ({ "z", ir_type_v<int> }, { { "x", ir_type_v<int> } }, name);
+
+  ir_variable& var_x = my_func.get_variable ("x");
+  ir_variable& var_z = my_func.get_variable ("z");
+
+  ir_block& block = get_entry_block (my_func);
+  block.append_with_def<ir_opcode::call> (
+    var_z,
+    ir_external_function_info { callee, ir_external_function_info::linkage::jit },
+    var_x);
+  block.append_with_def<ir_opcode::mul> (var_z, var_z, 2);
+
+  return generate_static_function (my_func);
+}
+
+// Computes `callee (x)` for a `double` argument, whatever the callee takes.
+static
+ir_static_function
+create_double_caller_function (std::string_view name, std::string_view callee)
+{
+  ir_function my_func ({ "z", ir_type_v<double> }, { { "x", ir_type_v<double> } }, name);
+
+  ir_block& block = get_entry_block (my_func);
+  block.append_with_def<ir_opcode::call> (
+    my_func.get_variable ("z"),
+    ir_external_function_info { callee, ir_external_function_info::linkage::jit },
+    my_func.get_variable ("x"));
+
+  return generate_static_function (my_func);
+}
+
+int
+main (void)
+{
+  try
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+
+    // The callee is compiled separately, so the call is bound by the linker.
+    jit.compile (create_add_constant_function ("add_one", 1));
+    void *caller = jit.compile (create_caller_function ("twice_add_one", "add_one"));
+    if (invoke_compiled_function<int> (caller, 3) != 8)
+      throw std::runtime_error ("Incorrect result calling a separately compiled function.");
+
+    // A function deduplicated against another still has a symbol of its own.
+    jit.compile (create_add_constant_function ("also_add_one", 1));
+    void *dedup_caller = jit.compile (create_caller_function ("twice_also_add_one",
+                                                             "also_add_one"));
+    if (invoke_compiled_function<int> (dedup_caller, 3) != 8)
+      throw std::runtime_error ("Incorrect result calling a deduplicated function.");
+
+    // A callee which has not been compiled must not be bound to a host function.
+    try
+    {
+      jit.compile (create_caller_function ("twice_abs", "abs"));
+      throw std::runtime_error ("Calling a function which was not compiled should throw.");
+    }
+    catch (const ir_exception&)
+    { }
+
+    // Compiled together, the callee may be inlined. It comes after its caller here, so the
+    // caller declares it first.
+    ir_static_function batch_caller = create_caller_function ("twice_add_two", "add_two");
+    ir_static_function batch_callee = create_add_constant_function ("add_two", 2);
+    std::vector<void *> addrs = jit.compile_batch ({ nonnull_ptr { batch_caller },
+                                                     nonnull_ptr { batch_callee } });
+    if (invoke_compiled_function<int> (addrs[0], 3) != 10
+        ||  invoke_compiled_function<int> (addrs[1], 3) != 5)
+    {
+      throw std::runtime_error ("Incorrect result calling a function in the same batch.");
+    }
+
+    // A member of a batch which is deduplicated against earlier code may still be called by
+    // the other members.
+    jit.compile (create_add_constant_function ("add_seven", 7));
+    ir_static_function dedup_batch_caller = create_caller_function ("twice_add_7", "add_7");
+    ir_static_function dedup_batch_callee = create_add_constant_function ("add_7", 7);
+    std::vector<void *> dedup_addrs = jit.compile_batch ({ nonnull_ptr { dedup_batch_caller },
+                                                           nonnull_ptr { dedup_batch_callee } });
+    if (invoke_compiled_function<int> (dedup_addrs[0], 3) != 20)
+      throw std::runtime_error ("Incorrect result calling a deduplicated member of a batch.");
+
+    // Only the definition in the same batch may be called, so its signature must match.
+    try
+    {
+      ir_static_function bad_caller = create_double_caller_function ("bad_caller", "add_three");
+      ir_static_function bad_callee = create_add_constant_function ("add_three", 3);
+      jit.compile_batch ({ nonnull_ptr { bad_caller }, nonnull_ptr { bad_callee } });
+      throw std::runtime_error ("Calling with a different signature should throw.");
+    }
+    catch (const ir_exception&)
+    { }
+
+    // Calls to a published function go through its entry point, and so follow new versions.
+    jit.publish (create_add_constant_function ("add_n", 1));
+    void *swapped = jit.compile (create_caller_function ("twice_add_n", "add_n"));
+    if (invoke_compiled_function<int> (swapped, 3) != 8)
+      throw std::runtime_error ("Incorrect result calling a published function.");
+
+    jit.publish (create_add_constant_function ("add_n", 5));
+    if (invoke_compiled_function<int> (swapped, 3) != 16)
+      throw std::runtime_error ("Callers should call the newest published version.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: jit call" << std::endl;
+  return 0;
+}
@@ -0,0 +1,61 @@
+/** test-jit-function.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+using namespace gch;
+
+template <typename Signature>
+static
+bool
+rejects (octave_jit_compiler& jit, const ir_static_function& func)
+{
+  try
+  {
+    (void)jit.compile<Signature> (func);
+  }
+  catch (const ir_exception&)
+  {
+    return true;
+  }
+  return false;
+}
+
+int
+main (void)
+{
+  try
+  {
+    ir_static_function func = create_add_function<double> ("add");
+
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+
+    octave_jit_function<double (double, double)> add = jit.compile<double (double, double)> (func);
+    if (! add || add (1.5, 2.0) != 3.5)
+      throw std::runtime_error ("Incorrect result from the typed handle.");
+
+    if (! rejects<double (double)> (jit, func))
+      throw std::runtime_error ("A signature with too few arguments was accepted.");
+
+    if (! rejects<double (double, int)> (jit, func))
+      throw std::runtime_error ("A signature with the wrong argument type was accepted.");
+
+    if (! rejects<int (double, double)> (jit, func))
+      throw std::runtime_error ("A signature with the wrong result type was accepted.");
+
+    if (! rejects<void (double, double)> (jit, func))
+      throw std::runtime_error ("A void signature for a function with a result was accepted.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: jit_function" << std::endl;
+  return 0;
+}
@@ -0,0 +1,63 @@
+/** test-jit-registration.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#  include <unistd.h>
+#endif
+
+using namespace gch;
+
+static
+ir_static_function
+create_function (void)
+{
+  ir_function my_func ({ "z", ir_type_v<int> }, { { "x", ir_type_v<int> } },
+                       "octave_ir_registered");
+
+  ir_block& block = get_entry_block (my_func);
+  block.append_with_def<ir_opcode::add> (my_func.get_variable ("z"),
+                                         my_func.get_variable ("x"),
+                                         1);
+
+  return generate_static_function (my_func);
+}
+
+int
+main (void)
+{
+  try
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+    jit.enable_jit_registration ();
+
+    void *addr = jit.compile (create_function ());
+    if (invoke_compiled_function<int> (addr, 4) != 5)
+      throw std::runtime_error ("Incorrect result.");
+
+#ifdef __linux__
+    std::ifstream perf_map ("/tmp/perf-" + std::to_string (getpid ()) + ".map");
+    std::stringstream contents;
+    contents << perf_map.rdbuf ();
+    if (contents.str ().find ("octave_ir_registered") == std::string::npos)
+      throw std::runtime_error ("The function was not written to the perf map.");
+#endif
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: jit registration" << std::endl;
+  return 0;
+}
@@ -0,0 +1,52 @@
+/** test-jitlink.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+using namespace gch;
+
+int
+main (void)
+{
+  try
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> (
+      octave_jit_llvm_linker::jitlink);
+
+    void *addr = jit.compile (create_add_constant_function ("f", 1));
+    if (invoke_compiled_function<int> (addr, 4) != 5)
+      throw std::runtime_error ("Incorrect result.");
+
+    addr = jit.replace (create_add_constant_function ("f", 2));
+    if (invoke_compiled_function<int> (addr, 4) != 6)
+      throw std::runtime_error ("Incorrect result after replacement.");
+
+    std::vector<ir_static_function> funcs;
+    funcs.push_back (create_add_constant_function ("g", 3));
+    funcs.push_back (create_add_constant_function ("h", 4));
+
+    octave_jit_compiler::function_refs refs;
+    for (const ir_static_function& func : funcs)
+      refs.push_back (nonnull_ptr { func });
+
+    std::vector<void *> addrs = jit.compile_batch (refs);
+
+    if (invoke_compiled_function<int> (addrs[0], 1) != 4
+        ||  invoke_compiled_function<int> (addrs[1], 1) != 5)
+    {
+      throw std::runtime_error ("Incorrect result for a batch.");
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: jitlink" << std::endl;
+  return 0;
+}
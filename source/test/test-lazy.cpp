@@ -0,0 +1,57 @@
+/** test-lazy.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace gch;
+
+int
+main (void)
+{
+  try
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+    jit.enable_printing ();
+    jit.enable_statistics ();
+
+    // Only `called` should be compiled (and printed), and only after the stubs have been created.
+    void *called     = jit.compile_lazy (create_add_constant_function ("called", -3));
+    void *not_called = jit.compile_lazy (create_add_constant_function ("not_called", -4));
+
+    if (called == nullptr || not_called == nullptr || called == not_called)
+      throw std::runtime_error ("Expected distinct stubs.");
+
+    std::cout << "Stubs created." << std::endl;
+
+    if (! jit.get_statistics ().modules.empty ())
+      throw std::runtime_error ("Creating a stub should not compile the function.");
+
+    if (invoke_compiled_function<int> (called, 10) != 7)
+      throw std::runtime_error ("Incorrect result on the first call through the stub.");
+
+    std::vector<octave_jit_module_stats> modules = jit.get_statistics ().modules;
+    if (modules.size () != 1 || modules.front ().functions != std::vector<std::string> { "called" })
+      throw std::runtime_error ("The first call should compile only the function it calls.");
+
+    if (invoke_compiled_function<int> (called, 20) != 17)
+      throw std::runtime_error ("Incorrect result on a later call through the stub.");
+
+    if (jit.get_statistics ().modules.size () != 1)
+      throw std::runtime_error ("A later call should not compile the function again.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: lazy" << std::endl;
+  return 0;
+}
@@ -0,0 +1,65 @@
+/** test-map.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+#include <vector>
+
+using namespace gch;
+
+int
+main (void)
+{
+  using map_type = void (*) (const double *, const double *, double *, std::size_t);
+
+  try
+  {
+    ir_static_function func = create_add_function<double> ("add");
+
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+
+    // The scalar and map entry points are independent.
+    void *scalar = jit.compile (func);
+    auto  map    = reinterpret_cast<map_type> (jit.compile_map (func));
+
+    if (invoke_compiled_function<double> (scalar, 1.0, 2.0) != 3.0)
+      throw std::runtime_error ("Incorrect result for the scalar entry point.");
+
+    // An odd length exercises the remainder loop after the vectorized body.
+    constexpr std::size_t n = 1027;
+    std::vector<double> x (n);
+    std::vector<double> y (n);
+    std::vector<double> z (n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      x[i] = static_cast<double> (i);
+      y[i] = 0.5 * static_cast<double> (i);
+    }
+
+    map (x.data (), y.data (), z.data (), n);
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      if (z[i] != x[i] + y[i])
+        throw std::runtime_error ("Incorrect result at index " + std::to_string (i) + ".");
+    }
+
+    // An empty range must not touch the arrays.
+    map (nullptr, nullptr, nullptr, 0);
+
+    if (reinterpret_cast<map_type> (jit.compile_map (func)) != map)
+      throw std::runtime_error ("Recompiling a map entry point should return the same address.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: map" << std::endl;
+  return 0;
+}
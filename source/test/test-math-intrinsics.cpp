@@ -0,0 +1,78 @@
+/** test-math-intrinsics.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+using namespace gch;
+
+// Computes `fma (sqrt (x), y, fabs (y))`, where the functions have the given suffix.
+template <typename T>
+static
+ir_static_function
+create_math_function (std::string_view name, std::string_view suffix)
+{
+  ir_function my_func ({ "z", ir_type_v<T> },
+                       { { "x", ir_type_v<T> }, { "y", ir_type_v<T> } },
+                       name);
+
+  ir_variable& var_x = my_func.get_variable ("x");
+  ir_variable& var_y = my_func.get_variable ("y");
+  ir_variable& var_z = my_func.get_variable ("z");
+  ir_variable& var_a = my_func.template create_variable<T> ("a");
+
+  ir_block& block = get_entry_block (my_func);
+  block.append_with_def<ir_opcode::call> (
+    var_z, ir_external_function_info { "sqrt" + std::string (suffix) }, var_x);
+  block.append_with_def<ir_opcode::call> (
+    var_a, ir_external_function_info { "fabs" + std::string (suffix) }, var_y);
+  block.append_with_def<ir_opcode::call> (
+    var_z, ir_external_function_info { "fma" + std::string (suffix) }, var_z, var_y, var_a);
+
+  return generate_static_function (my_func);
+}
+
+int
+main (void)
+{
+  try
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+
+    void *math = jit.compile (create_math_function<double> ("math", ""));
+    if (invoke_compiled_function<double> (math, 16., -2.) != 4. * -2. + 2.)
+      throw std::runtime_error ("Incorrect result from the double math functions.");
+
+    void *mathf = jit.compile (create_math_function<float> ("mathf", "f"));
+    if (invoke_compiled_function<float> (mathf, 9.f, 3.f) != 3.f * 3.f + 3.f)
+      throw std::runtime_error ("Incorrect result from the float math functions.");
+
+#if defined (__x86_64__) || defined (_M_X64)
+    // Scalar code never calls into the vector library, so it links without it.
+    jit.set_vector_library (octave_jit_vector_library::libmvec);
+    void *vec = jit.compile (create_math_function<double> ("math_vec", ""));
+    if (invoke_compiled_function<double> (vec, 25., 1.) != 5. + 1.)
+      throw std::runtime_error ("Incorrect result with a vector library.");
+#else
+    // LLVM only knows the x86-64 variants of libmvec.
+    try
+    {
+      jit.set_vector_library (octave_jit_vector_library::libmvec);
+      throw std::runtime_error ("Selecting libmvec for another target should throw.");
+    }
+    catch (const ir_exception&)
+    { }
+#endif
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: math intrinsics" << std::endl;
+  return 0;
+}
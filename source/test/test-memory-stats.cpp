@@ -0,0 +1,80 @@
+/** test-memory-stats.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+#include <string>
+
+using namespace gch;
+
+static
+void
+check_consistent (const octave_jit_memory_usage& usage)
+{
+  if (usage.reserved < usage.allocated || usage.allocated < usage.used)
+    throw std::runtime_error ("Inconsistent memory usage.");
+
+  if (usage.fragmentation < 0.0 || 1.0 < usage.fragmentation)
+    throw std::runtime_error ("Fragmentation out of range.");
+}
+
+int
+main (void)
+{
+  try
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+
+    constexpr int num_funcs = 64;
+    for (int i = 0; i < num_funcs; ++i)
+    {
+      std::string name = "f" + std::to_string (i);
+      void *addr = jit.compile (create_add_constant_function (name, i));
+      if (invoke_compiled_function<int> (addr, 1) != i + 1)
+        throw std::runtime_error ("Incorrect result for `" + name + "`.");
+    }
+
+    octave_jit_memory_stats stats = jit.get_memory_stats ();
+    check_consistent (stats.code);
+    check_consistent (stats.rodata);
+    check_consistent (stats.data);
+
+    if (stats.code.used == 0)
+      throw std::runtime_error ("Code should have been allocated.");
+
+    std::size_t reserved = stats.code.reserved;
+
+    for (int i = 0; i < num_funcs; ++i)
+      jit.release ("f" + std::to_string (i));
+
+    stats = jit.get_memory_stats ();
+    if (stats.code.used != 0 || stats.code.allocated != 0)
+      throw std::runtime_error ("Released code should be returned to the allocator.");
+
+    // Freed ranges are reused rather than mapping more memory.
+    for (int i = 0; i < num_funcs; ++i)
+    {
+      std::string name = "g" + std::to_string (i);
+      void *addr = jit.compile (create_add_constant_function (name, i));
+      if (invoke_compiled_function<int> (addr, 2) != i + 2)
+        throw std::runtime_error ("Incorrect result for `" + name + "`.");
+    }
+
+    stats = jit.get_memory_stats ();
+    check_consistent (stats.code);
+    if (stats.code.reserved != reserved)
+      throw std::runtime_error ("Freed code memory should have been reused.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: memory stats" << std::endl;
+  return 0;
+}
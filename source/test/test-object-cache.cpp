@@ -0,0 +1,112 @@
+/** test-object-cache.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+#include <filesystem>
+
+using namespace gch;
+
+// Has internal linkage, so it cannot be found by searching the process.
+static
+int
+triple (int x)
+{
+  return 3 * x;
+}
+
+static
+std::size_t
+count_cached_objects (const std::filesystem::path& dir)
+{
+  return static_cast<std::size_t> (std::distance (std::filesystem::directory_iterator (dir),
+                                                  std::filesystem::directory_iterator { }));
+}
+
+int
+main (void)
+{
+  namespace fs = std::filesystem;
+
+  fs::path cache_dir = fs::temp_directory_path () / "octave-ir-test-object-cache";
+  fs::remove_all (cache_dir);
+
+  try
+  {
+    ir_static_function my_static_func = create_add_function<int> ("add");
+
+    // The first compiler populates the cache.
+    {
+      auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+      jit.enable_object_cache (cache_dir.string ());
+
+      if (invoke_compiled_function<int> (jit.compile (my_static_func), 2, 3) != 5)
+        throw std::runtime_error ("Incorrect result on a cache miss.");
+    }
+
+    if (count_cached_objects (cache_dir) != 1)
+      throw std::runtime_error ("Expected exactly one cached object.");
+
+    // A fresh compiler (as in a new session) should load the object from the cache.
+    {
+      auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+      jit.enable_object_cache (cache_dir.string ());
+      jit.enable_statistics ();
+
+      if (invoke_compiled_function<int> (jit.compile (my_static_func), 2, 3) != 5)
+        throw std::runtime_error ("Incorrect result on a cache hit.");
+
+      octave_jit_compile_stats stats = jit.get_statistics ();
+      if (stats.modules.size () != 1 || ! stats.modules.front ().cached)
+        throw std::runtime_error ("The second compiler should have hit the cache.");
+
+      for (octave_jit_compile_phase phase : { octave_jit_compile_phase::translate,
+                                              octave_jit_compile_phase::optimize,
+                                              octave_jit_compile_phase::codegen })
+      {
+        if (stats.phases[static_cast<std::size_t> (phase)].count != 0)
+          throw std::runtime_error ("A cache hit should skip translation and codegen.");
+      }
+    }
+
+    if (count_cached_objects (cache_dir) != 1)
+      throw std::runtime_error ("A cache hit should not store another object.");
+
+    // Calls to a runtime function depend on the attributes it was registered with.
+    ir_static_function caller = create_caller_function ("caller", "octave_ir_test_triple");
+    for (bool does_not_throw : { true, false })
+    {
+      auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+      jit.enable_object_cache (cache_dir.string ());
+      jit.enable_statistics ();
+
+      octave_jit_runtime_attributes attrs;
+      attrs.does_not_throw = does_not_throw;
+      jit.register_runtime_function ("octave_ir_test_triple", &triple, attrs);
+
+      if (invoke_compiled_function<int> (jit.compile (caller), 4) != 13)
+        throw std::runtime_error ("Incorrect result calling a runtime function.");
+
+      octave_jit_compile_stats stats = jit.get_statistics ();
+      if (stats.modules.size () != 1 || stats.modules.front ().cached)
+        throw std::runtime_error ("Different runtime attributes should miss the cache.");
+    }
+
+    if (count_cached_objects (cache_dir) != 3)
+      throw std::runtime_error ("Expected an object for each set of runtime attributes.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    fs::remove_all (cache_dir);
+    return 1;
+  }
+
+  fs::remove_all (cache_dir);
+  std::cout << "OK: object cache" << std::endl;
+  return 0;
+}
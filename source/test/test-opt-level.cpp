@@ -0,0 +1,73 @@
+/** test-opt-level.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+using namespace gch;
+
+static
+ir_static_function
+create_mul_add_function (void)
+{
+  ir_function my_func ({ "z", ir_type_v<double> },
+                       { { "x", ir_type_v<double> }, { "y", ir_type_v<double> } });
+
+  ir_variable& var_x = my_func.get_variable ("x");
+  ir_variable& var_y = my_func.get_variable ("y");
+  ir_variable& var_z = my_func.get_variable ("z");
+
+  ir_block& block = get_entry_block (my_func);
+  block.append_with_def<ir_opcode::mul> (var_z, var_x, var_y);
+  block.append_with_def<ir_opcode::add> (var_z, var_z, var_x);
+
+  return generate_static_function (my_func);
+}
+
+int
+main (void)
+{
+  constexpr octave_jit_optimization_level levels[] {
+    octave_jit_optimization_level::O0,
+    octave_jit_optimization_level::O1,
+    octave_jit_optimization_level::O2,
+    octave_jit_optimization_level::O3,
+    octave_jit_optimization_level::Os,
+    octave_jit_optimization_level::Oz,
+  };
+
+  try
+  {
+    ir_static_function my_static_func = create_mul_add_function ();
+
+    for (octave_jit_optimization_level level : levels)
+    {
+      auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+      jit.set_optimization_level (level);
+      jit.append_passes ("function(instcombine)");
+
+      if (invoke_compiled_function<double> (jit.compile (my_static_func), 3., 4.) != 15.)
+        throw std::runtime_error ("Incorrect result.");
+    }
+
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+    try
+    {
+      jit.append_passes ("not-a-pass");
+      throw std::runtime_error ("An invalid pipeline should be rejected.");
+    }
+    catch (const ir_exception&)
+    { }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: optimization levels" << std::endl;
+  return 0;
+}
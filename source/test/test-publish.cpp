@@ -0,0 +1,87 @@
+/** test-publish.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+using namespace gch;
+
+int
+main (void)
+{
+  try
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+
+    void *entry = jit.publish (create_add_constant_function ("myloopfunc", 1));
+    if (invoke_compiled_function<int> (entry, 1) != 2)
+      throw std::runtime_error ("Incorrect result for the first version.");
+
+    // Recompiling a modified function must not collide with the previous definition.
+    if (jit.publish (create_add_constant_function ("myloopfunc", 2)) != entry)
+      throw std::runtime_error ("The entry point should be the same for every version.");
+
+    if (invoke_compiled_function<int> (entry, 1) != 3)
+      throw std::runtime_error ("The entry point should call the newest version.");
+
+    if (jit.find ("myloopfunc") != entry)
+      throw std::runtime_error ("The cache should return the entry point.");
+
+    void *first = jit.find ("myloopfunc#1");
+    if (! first || invoke_compiled_function<int> (first, 1) != 2)
+      throw std::runtime_error ("The first version should still be reachable.");
+
+    if (! jit.redirect ("myloopfunc", 1) || invoke_compiled_function<int> (entry, 1) != 2)
+      throw std::runtime_error ("Failed to roll back to the first version.");
+
+    if (jit.redirect ("myloopfunc", 3) || jit.redirect ("other", 1))
+      throw std::runtime_error ("Redirecting to a missing version should fail.");
+
+    // Once nothing refers to it, a version may be released.
+    if (! jit.release ("myloopfunc#2") || jit.find ("myloopfunc#2"))
+      throw std::runtime_error ("Failed to release the second version.");
+
+    if (jit.redirect ("myloopfunc", 2))
+      throw std::runtime_error ("Redirecting to a released version should fail.");
+
+    void *plain = jit.compile (create_add_constant_function ("plain", 5));
+    if (jit.find ("plain") != plain || jit.find ("missing"))
+      throw std::runtime_error ("The cache should hold compiled functions.");
+
+    // The entry point and an ordinary function cannot share a name.
+    try
+    {
+      jit.publish (create_add_constant_function ("plain", 6));
+      throw std::runtime_error ("Publishing a compiled name should throw.");
+    }
+    catch (const ir_exception&)
+    { }
+
+    try
+    {
+      jit.compile (create_add_constant_function ("myloopfunc", 7));
+      throw std::runtime_error ("Compiling a published name should throw.");
+    }
+    catch (const ir_exception&)
+    { }
+
+    // The version which the entry point refers to cannot be released.
+    if (jit.release ("myloopfunc#1") || invoke_compiled_function<int> (entry, 1) != 2)
+      throw std::runtime_error ("Releasing the current version should fail.");
+
+    jit.publish (create_add_constant_function ("myloopfunc", 8));
+    if (! jit.release ("myloopfunc#1"))
+      throw std::runtime_error ("Failed to release a version which is no longer current.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: publish" << std::endl;
+  return 0;
+}
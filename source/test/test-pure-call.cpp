@@ -0,0 +1,75 @@
+/** test-pure-call.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+using namespace gch;
+
+static int num_calls = 0;
+
+// Counts its calls, so that we can see which ones the optimizer removed. It lies about being
+// pure, which is fine for the test.
+static
+int
+counted_square (int x)
+{
+  ++num_calls;
+  return x * x;
+}
+
+// Computes `square (x) + square (x)`.
+static
+ir_static_function
+create_double_square_function (std::string_view name,
+                               const ir_external_function_info::attributes& attrs)
+{
+  ir_function my_func ({ "z", ir_type_v<int> }, { { "x", ir_type_v<int> } }, name);
+
+  ir_variable& var_x = my_func.get_variable ("x");
+  ir_variable& var_y = my_func.create_variable<int> ("y");
+  ir_variable& var_z = my_func.get_variable ("z");
+
+  ir_external_function_info square { "octave_ir_test_square", attrs };
+
+  ir_block& block = get_entry_block (my_func);
+  block.append_with_def<ir_opcode::call> (var_y, square, var_x);
+  block.append_with_def<ir_opcode::call> (var_z, square, var_x);
+  block.append_with_def<ir_opcode::add> (var_z, var_z, var_y);
+
+  return generate_static_function (my_func);
+}
+
+int
+main (void)
+{
+  try
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+    jit.register_runtime_function ("octave_ir_test_square", &counted_square);
+
+    void *opaque = jit.compile (create_double_square_function ("opaque", { }));
+    if (invoke_compiled_function<int> (opaque, 3) != 18 || num_calls != 2)
+      throw std::runtime_error ("Both calls should be made without attributes.");
+
+    num_calls = 0;
+    void *pure = jit.compile (
+      create_double_square_function ("pure", ir_external_function_info::attributes::pure ()));
+    if (invoke_compiled_function<int> (pure, 3) != 18)
+      throw std::runtime_error ("Incorrect result from the pure function.");
+
+    if (num_calls != 1)
+      throw std::runtime_error ("The calls to the pure function should have been combined.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: pure call" << std::endl;
+  return 0;
+}
@@ -0,0 +1,141 @@
+/** test-release.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+using namespace gch;
+
+// Calls a function which is never compiled, so compiling this fails.
+static
+ir_static_function
+create_missing_call_function (std::string_view name)
+{
+  ir_function my_func ({ "z", ir_type_v<int> }, { { "x", ir_type_v<int> } }, name);
+
+  ir_block& block = get_entry_block (my_func);
+  block.append_with_def<ir_opcode::call> (
+    my_func.get_variable ("z"),
+    ir_external_function_info { "missing", ir_external_function_info::linkage::jit },
+    my_func.get_variable ("x"));
+
+  return generate_static_function (my_func);
+}
+
+int
+main (void)
+{
+  try
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+
+    if (jit.release ("f"))
+      throw std::runtime_error ("Releasing an unknown function should fail.");
+
+    void *addr = jit.compile (create_add_constant_function ("f", 1));
+    if (invoke_compiled_function<int> (addr, 4) != 5)
+      throw std::runtime_error ("Incorrect result for the first definition.");
+
+    if (! jit.release ("f"))
+      throw std::runtime_error ("Releasing a compiled function should succeed.");
+
+    // The name is free to be defined again.
+    addr = jit.compile (create_add_constant_function ("f", 2));
+    if (invoke_compiled_function<int> (addr, 4) != 6)
+      throw std::runtime_error ("Incorrect result for the second definition.");
+
+    addr = jit.replace (create_add_constant_function ("f", 3));
+    if (invoke_compiled_function<int> (addr, 4) != 7)
+      throw std::runtime_error ("Incorrect result for the replacement.");
+
+    if (jit.replace (create_add_constant_function ("f", 3)) != addr)
+      throw std::runtime_error ("Replacing with an identical body should keep the code.");
+
+    // The old definition is kept if the new one fails to compile.
+    try
+    {
+      jit.replace (create_missing_call_function ("f"));
+      throw std::runtime_error ("Replacing with a body which cannot compile should throw.");
+    }
+    catch (const ir_exception&)
+    { }
+
+    if (jit.find ("f") != addr || invoke_compiled_function<int> (addr, 4) != 7)
+      throw std::runtime_error ("A failed replacement should leave the old definition.");
+
+    // The name of a published function belongs to its entry point.
+    jit.publish (create_add_constant_function ("p", 1));
+    try
+    {
+      jit.replace (create_add_constant_function ("p", 2));
+      throw std::runtime_error ("Replacing a published function should throw.");
+    }
+    catch (const ir_exception&)
+    { }
+
+    // A released body must not be handed out by deduplication.
+    addr = jit.compile (create_add_constant_function ("g", 2));
+    if (invoke_compiled_function<int> (addr, 4) != 6)
+      throw std::runtime_error ("Incorrect result after releasing a duplicate body.");
+
+    // Functions which share code are released one at a time.
+    void *shared_first = jit.compile (create_add_constant_function ("shared_first", 5));
+    jit.compile (create_add_constant_function ("shared_second", 5));
+
+    addr = jit.replace (create_add_constant_function ("shared_second", 6));
+    if (invoke_compiled_function<int> (addr, 1) != 7)
+      throw std::runtime_error ("Incorrect result for the replaced member of a shared pair.");
+
+    if (jit.find ("shared_first") != shared_first
+        ||  invoke_compiled_function<int> (shared_first, 1) != 6)
+    {
+      throw std::runtime_error ("Replacing a function should keep the code it shared.");
+    }
+
+    // The code is still in use under its original name, so that name cannot be given new code.
+    try
+    {
+      jit.replace (create_add_constant_function ("shared_first", 7));
+      throw std::runtime_error ("Replacing the original name of shared code should throw.");
+    }
+    catch (const ir_exception&)
+    { }
+
+    if (invoke_compiled_function<int> (shared_first, 1) != 6)
+      throw std::runtime_error ("A failed replacement should keep the shared code.");
+
+    void *shared_copy = jit.compile (create_add_constant_function ("shared_copy", 5));
+    if (! jit.release ("shared_first") || jit.find ("shared_first"))
+      throw std::runtime_error ("Failed to release one member of a shared pair.");
+
+    if (invoke_compiled_function<int> (shared_copy, 1) != 6)
+      throw std::runtime_error ("Releasing a function should keep the code it shared.");
+
+    if (! jit.release ("shared_copy"))
+      throw std::runtime_error ("Failed to release the last member of a shared pair.");
+
+    // Once the code is freed, the name is free to be defined again.
+    addr = jit.compile (create_add_constant_function ("shared_first", 8));
+    if (invoke_compiled_function<int> (addr, 1) != 9)
+      throw std::runtime_error ("Incorrect result after freeing shared code.");
+
+    // Redefine repeatedly under the same name, as a long-running session would.
+    for (int i = 0; i < 100; ++i)
+    {
+      addr = jit.replace (create_add_constant_function ("h", 10 + i));
+      if (invoke_compiled_function<int> (addr, 1) != 11 + i)
+        throw std::runtime_error ("Incorrect result for a redefinition.");
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: release" << std::endl;
+  return 0;
+}
@@ -0,0 +1,71 @@
+/** test-runtime-library.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+#include <vector>
+
+using namespace gch;
+
+// Has internal linkage, so it cannot be found by searching the process.
+static
+int
+triple (int x)
+{
+  return 3 * x;
+}
+
+int
+main (void)
+{
+  try
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+
+    octave_jit_runtime_attributes attrs;
+    attrs.does_not_throw         = true;
+    attrs.does_not_access_memory = true;
+    jit.register_runtime_function ("octave_ir_test_triple", &triple, attrs);
+
+    void *caller = jit.compile (create_caller_function ("triple_plus_one",
+                                                        "octave_ir_test_triple"));
+    if (invoke_compiled_function<int> (caller, 4) != 13)
+      throw std::runtime_error ("Incorrect result calling a runtime function.");
+
+    // Calls from a batch share a single declaration.
+    ir_static_function first  = create_caller_function ("first_caller", "octave_ir_test_triple");
+    ir_static_function second = create_caller_function ("second_caller", "octave_ir_test_triple");
+    std::vector<void *> addrs = jit.compile_batch ({ nonnull_ptr { first },
+                                                     nonnull_ptr { second } });
+    if (invoke_compiled_function<int> (addrs[0], 1) != 4
+        ||  invoke_compiled_function<int> (addrs[1], 2) != 7)
+    {
+      throw std::runtime_error ("Incorrect result calling a runtime function from a batch.");
+    }
+
+    bool threw = false;
+    try
+    {
+      jit.register_runtime_function ("octave_ir_test_triple", &triple);
+    }
+    catch (const ir_exception&)
+    {
+      threw = true;
+    }
+
+    if (! threw)
+      throw std::runtime_error ("Registering a name twice should throw.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: runtime library" << std::endl;
+  return 0;
+}
@@ -0,0 +1,108 @@
+/** test-shared.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gch;
+
+int
+main (void)
+{
+  constexpr int num_threads    = 8;
+  constexpr int num_iterations = 32;
+  constexpr int num_shared     = 8;
+
+  // The shared functions are created up front since every thread compiles them.
+  std::vector<ir_static_function> shared_funcs;
+  for (int c = 0; c < num_shared; ++c)
+    shared_funcs.push_back (create_add_constant_function ("shared_" + std::to_string (c), c));
+
+  std::mutex         error_mutex;
+  std::exception_ptr error;
+  std::atomic<bool>  done { false };
+
+  auto worker = [&](int id) {
+    try
+    {
+      octave_jit_compiler& jit = octave_jit_compiler::get_shared<octave_jit_compiler_llvm> ();
+      for (int i = 0; i < num_iterations; ++i)
+      {
+        // Every thread races to compile the same functions, which are deduplicated.
+        int c = (id + i) % num_shared;
+        if (invoke_compiled_function<int> (jit.compile (shared_funcs[c]), 1) != c + 1)
+          throw std::runtime_error ("Incorrect result for a shared function.");
+
+        // Each thread also compiles and releases functions of its own.
+        std::string name = "t" + std::to_string (id) + "_" + std::to_string (i);
+        int k = id * num_iterations + i;
+        void *addr = jit.compile (create_add_constant_function (name, k));
+        if (invoke_compiled_function<int> (addr, 2) != k + 2)
+          throw std::runtime_error ("Incorrect result for `" + name + "`.");
+
+        if (! jit.release (name))
+          throw std::runtime_error ("Failed to release `" + name + "`.");
+      }
+    }
+    catch (...)
+    {
+      std::scoped_lock lock (error_mutex);
+      if (! error)
+        error = std::current_exception ();
+    }
+  };
+
+  // Settings change while the workers compile.
+  auto configurer = [&] {
+    octave_jit_compiler& jit = octave_jit_compiler::get_shared<octave_jit_compiler_llvm> ();
+    for (bool on = true; ! done; on = ! on)
+    {
+      jit.enable_statistics (on);
+      jit.enable_debug_info (on);
+      jit.set_optimization_level (on ? octave_jit_optimization_level::O1
+                                     : octave_jit_optimization_level::O2);
+      std::this_thread::yield ();
+    }
+  };
+
+  std::thread config_thread (configurer);
+
+  std::vector<std::thread> threads;
+  for (int id = 0; id < num_threads; ++id)
+    threads.emplace_back (worker, id);
+
+  std::for_each (threads.begin (), threads.end (), [](std::thread& t) { t.join (); });
+  done = true;
+  config_thread.join ();
+
+  try
+  {
+    if (error)
+      std::rethrow_exception (error);
+
+    if (&octave_jit_compiler::get_shared<octave_jit_compiler_llvm> ()
+        != &octave_jit_compiler::get_shared<octave_jit_compiler_llvm> ())
+    {
+      throw std::runtime_error ("The shared compiler should be unique.");
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: shared" << std::endl;
+  return 0;
+}
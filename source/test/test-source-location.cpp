@@ -0,0 +1,72 @@
+/** test-source-location.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+using namespace gch;
+
+static
+ir_static_function
+create_function (void)
+{
+  ir_function my_func ({ "z", ir_type_v<int> }, { { "x", ir_type_v<int> } }, "located");
+
+  ir_block& block = get_entry_block (my_func);
+  block.append_with_def<ir_opcode::add> (my_func.get_variable ("z"),
+                                         my_func.get_variable ("x"),
+                                         1);
+
+  return generate_static_function (my_func);
+}
+
+int
+main (void)
+{
+  try
+  {
+    ir_static_function func = create_function ();
+
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+    jit.set_optimization_level (octave_jit_optimization_level::O0);
+    jit.enable_debug_info ();
+
+    void *addr = jit.compile (func);
+    if (invoke_compiled_function<int> (addr, 4) != 5)
+      throw std::runtime_error ("Incorrect result.");
+
+    // The prologue has no instruction, so search past it.
+    std::optional<octave_jit_source_location> loc;
+    for (std::size_t offset = 0; offset < 64 && ! loc; ++offset)
+      loc = jit.find_source_location (static_cast<const char *> (addr) + offset);
+
+    if (! loc)
+      throw std::runtime_error ("No source location was found for the function.");
+
+    if (loc->function != "located")
+      throw std::runtime_error ("Incorrect function `" + loc->function + "`.");
+
+    if (func.num_blocks () <= loc->block_index)
+      throw std::runtime_error ("Block index out of range.");
+
+    if (loc->block_name != func[loc->block_index].get_name ())
+      throw std::runtime_error ("Incorrect block name `" + loc->block_name + "`.");
+
+    if (func[loc->block_index].size () <= loc->instruction_index)
+      throw std::runtime_error ("Instruction index out of range.");
+
+    if (jit.find_source_location (reinterpret_cast<const void *> (&create_function)))
+      throw std::runtime_error ("A location was found for code outside of the JIT.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: source location" << std::endl;
+  return 0;
+}
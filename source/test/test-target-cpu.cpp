@@ -0,0 +1,53 @@
+/** test-target-cpu.cpp
+ * Copyright © 2022 Gene Harvey
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "test-templates.hpp"
+
+using namespace gch;
+
+int
+main (void)
+{
+  try
+  {
+    auto jit = octave_jit_compiler::create<octave_jit_compiler_llvm> ();
+
+    // The host CPU is used by default.
+    if (invoke_compiled_function<int> (jit.compile (create_add_constant_function ("f", 1)), 4) != 5)
+      throw std::runtime_error ("Incorrect result for the host CPU.");
+
+    // Pin a baseline target, as for reproducible output.
+    jit.set_target_cpu ("x86-64", "+sse2");
+    if (invoke_compiled_function<int> (jit.compile (create_add_constant_function ("g", 2)), 4) != 6)
+      throw std::runtime_error ("Incorrect result for a pinned CPU.");
+
+    bool threw = false;
+    try
+    {
+      jit.set_target_cpu ("not-a-real-cpu");
+    }
+    catch (const ir_exception&)
+    {
+      threw = true;
+    }
+
+    if (! threw)
+      throw std::runtime_error ("An unrecognized CPU should be rejected.");
+
+    jit.set_target_cpu ("");
+    if (invoke_compiled_function<int> (jit.compile (create_add_constant_function ("h", 3)), 4) != 7)
+      throw std::runtime_error ("Incorrect result after restoring the host CPU.");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what () << std::endl;
+    return 1;
+  }
+
+  std::cout << "OK: target cpu" << std::endl;
+  return 0;
+}
@@ -14,31 +14,71 @@
 #  endif
 #endif
 
-#include "jit-exception.hpp"
-
 #include "gch/octave-ir-compiler-llvm.hpp"
 #include "ir-static-function.hpp"
 #include "ir-all-components.hpp"
 #include "ir-type-util.hpp"
 
-#include <csetjmp>
 #include <iostream>
-
-extern std::jmp_buf env_buffer;
-extern std::unique_ptr<std::exception> current_exception;
+#include <string_view>
 
 namespace gch
 {
 
+  // Computes `x + c`.
+  inline
+  ir_static_function
+  create_add_constant_function (std::string_view name, int c)
+  {
+    ir_function my_func ({ "z", ir_type_v<int> }, { { "x", ir_type_v<int> } }, name);
+
+    ir_block& block = get_entry_block (my_func);
+    block.append_with_def<ir_opcode::add> (my_func.get_variable ("z"),
+                                           my_func.get_variable ("x"),
+                                           c);
+
+    return generate_static_function (my_func);
+  }
+
+  // Computes `x + y`.
+  template <typename T>
+  ir_static_function
+  create_add_function (std::string_view name)
+  {
+    ir_function my_func ({ "z", ir_type_v<T> },
+                         { { "x", ir_type_v<T> }, { "y", ir_type_v<T> } },
+                         name);
+
+    ir_block& block = get_entry_block (my_func);
+    block.append_with_def<ir_opcode::add> (my_func.get_variable ("z"),
+                                           my_func.get_variable ("x"),
+                                           my_func.get_variable ("y"));
+
+    return generate_static_function (my_func);
+  }
+
+  // Computes `callee (x) + 1`, where `callee` is a host function.
+  inline
+  ir_static_function
+  create_caller_function (std::string_view name, std::string_view callee)
+  {
+    ir_function my_func ({ "z", ir_type_v<int> }, { { "x", ir_type_v<int> } }, name);
+
+    ir_variable& var_x = my_func.get_variable ("x");
+    ir_variable& var_z = my_func.get_variable ("z");
+
+    ir_block& block = get_entry_block (my_func);
+    block.append_with_def<ir_opcode::call> (var_z, ir_external_function_info { callee }, var_x);
+    block.append_with_def<ir_opcode::add> (var_z, var_z, 1);
+
+    return generate_static_function (my_func);
+  }
+
   template <typename Ret = void, typename ...Args>
   Ret
   invoke_compiled_function (void *func, Args... args)
   {
     auto casted_func = reinterpret_cast<Ret (*)(Args...)> (func);
-
-    if (setjmp (env_buffer))
-      throw jit_exception { std::move (current_exception) };
-
     return std::invoke (casted_func, args...);
   }
 